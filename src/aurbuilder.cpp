@@ -0,0 +1,684 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "aurbuilder.h"
+#include "packagemanager.h"
+#include "processexecutor.h"
+#include "systemaccess.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+
+namespace {
+
+/// "nvidia-utils>=550" -> "nvidia-utils"
+QString stripConstraint(const QString &dep)
+{
+    qsizetype end = 0;
+    while (end < dep.size() && dep.at(end) != '<' && dep.at(end) != '>' && dep.at(end) != '=')
+        ++end;
+    return dep.left(end).trimmed();
+}
+
+void appendUnique(QStringList &list, const QString &value)
+{
+    if (!value.isEmpty() && !list.contains(value))
+        list.append(value);
+}
+
+/// Arguments a process is keyed by in a system-access bundle. Every makepkg
+/// run has the same arguments, so the checkout it runs in is part of them.
+QStringList bundleArguments(const QStringList &args, const QString &workingDirectory)
+{
+    if (workingDirectory.isEmpty())
+        return args;
+    return QStringList(args) << "@" + QDir(AurBuilder::buildRoot()).relativeFilePath(workingDirectory);
+}
+
+} // namespace
+
+AurBuilder::AurBuilder(QObject *parent)
+    : QObject(parent)
+    , m_maxParallel(qBound(1, QThread::idealThreadCount() / 2, 4))
+{
+}
+
+AurBuilder::~AurBuilder()
+{
+    for (QProcess *process : std::as_const(m_processes)) {
+        process->kill();
+        process->waitForFinished(3000);
+    }
+}
+
+void AurBuilder::setAurHelper(const QString &helper)
+{
+    m_aurHelper = helper;
+}
+
+void AurBuilder::setMaxParallelBuilds(int count)
+{
+    m_maxParallel = qMax(1, count);
+}
+
+QString AurBuilder::buildRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+           + "/rscn-drivers/aur";
+}
+
+QString AurBuilder::writeManagedMakepkgConf()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+                        + "/rscn-drivers";
+    QDir().mkpath(dir);
+    const QString path = dir + "/makepkg.conf";
+
+    const int jobs = qMax(1, QThread::idealThreadCount());
+
+    // makepkg sources MAKEPKG_CONF in place of /etc/makepkg.conf, so pull the
+    // system config in first and only override what matters for build speed.
+    // The -l load limit keeps concurrent builds from oversubscribing the CPU.
+    QString conf;
+    conf += "# Managed by rscn-drivers, regenerated before every AUR build.\n";
+    conf += "source /etc/makepkg.conf\n";
+    conf += QString("MAKEFLAGS=\"-j%1 -l%1\"\n").arg(jobs);
+    conf += "if command -v ccache >/dev/null 2>&1; then\n";
+    conf += "    BUILDENV=(\"${BUILDENV[@]/#\\!ccache/ccache}\")\n";
+    conf += "    [[ \" ${BUILDENV[*]} \" == *\" ccache \"* ]] || BUILDENV+=(ccache)\n";
+    conf += "fi\n";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Cannot write managed makepkg.conf:" << file.errorString();
+        return {};
+    }
+    file.write(conf.toUtf8());
+    if (!file.commit())
+        return {};
+    return path;
+}
+
+QProcessEnvironment AurBuilder::buildEnvironment()
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    const QString conf = writeManagedMakepkgConf();
+    if (!conf.isEmpty())
+        env.insert("MAKEPKG_CONF", conf);
+    // Honoured even if a user makepkg.conf is sourced after ours
+    const int jobs = qMax(1, QThread::idealThreadCount());
+    env.insert("MAKEFLAGS", QString("-j%1 -l%1").arg(jobs));
+    return env;
+}
+
+QString AurBuilder::binaryRepository()
+{
+    QString location = qEnvironmentVariable("RSCN_AUR_BINARY_REPO");
+    if (location.isEmpty())
+        location = QSettings().value("aur/binaryRepository").toString();
+    if (location.isEmpty())
+        return {};
+
+    if (location.startsWith("file:"))
+        location = QUrl(location).toLocalFile();
+    return QDir::cleanPath(location);
+}
+
+// =============================================================================
+// Pipeline
+// =============================================================================
+
+void AurBuilder::start(const QStringList &packages)
+{
+    if (isRunning()) {
+        emit finished(false, tr("Another operation is already running"));
+        return;
+    }
+
+    m_requested = packages;
+    m_builds.clear();
+    m_buildTimers.clear();
+    m_nextBuild = 0;
+    m_runningBuilds = 0;
+
+    // Fetch into a clean tree so stale checkouts are never built; a replay
+    // reads the recorded tree instead
+    const QString root = buildRoot();
+    if (SystemAccess::instance().mode() != SystemAccess::Mode::Replay) {
+        QDir(root).removeRecursively();
+        if (!QDir().mkpath(root)) {
+            emit finished(false, tr("Cannot create AUR build directory: %1").arg(root));
+            return;
+        }
+    }
+
+    m_stage = Stage::Fetch;
+    emit output(tr("Fetching PKGBUILDs: %1").arg(packages.join(' ')));
+
+    launch(m_aurHelper, QStringList() << "-G" << packages, root, QString(),
+           [this](int exitCode, const QByteArray &) { onFetchFinished(exitCode == 0); });
+}
+
+void AurBuilder::onFetchFinished(bool ok)
+{
+    if (m_stage != Stage::Fetch)
+        return;
+    if (!ok) {
+        runSerialFallback(tr("fetching PKGBUILDs failed"));
+        return;
+    }
+
+    // Split packages share one checkout named after the pkgbase
+    const QString root = buildRoot();
+    QStringList found;
+    const QStringList dirs = SystemAccess::instance().entryList(root);
+    for (const QString &dir : dirs) {
+        AurBuild build;
+        if (!parseSrcinfo(root + "/" + dir, build))
+            continue;
+        for (const QString &name : std::as_const(build.pkgnames)) {
+            if (m_requested.contains(name)) {
+                build.wanted.append(name);
+                found.append(name);
+            }
+        }
+        if (!build.wanted.isEmpty())
+            m_builds.append(build);
+    }
+
+    for (const QString &pkg : std::as_const(m_requested)) {
+        if (!found.contains(pkg)) {
+            runSerialFallback(tr("no .SRCINFO found for %1").arg(pkg));
+            return;
+        }
+    }
+
+    // Everything the pkgbases in this set produce themselves
+    QStringList produced;
+    for (const AurBuild &build : std::as_const(m_builds))
+        produced.append(build.pkgnames);
+
+    for (AurBuild &build : m_builds) {
+        // Install in-set runtime dependencies in the same transaction
+        for (const QString &dep : std::as_const(build.depends)) {
+            if (build.pkgnames.contains(dep))
+                appendUnique(build.wanted, dep);
+        }
+    }
+
+    // Reuse packages another machine already built at this exact version
+    const QString repository = binaryRepository();
+    if (!repository.isEmpty()) {
+        for (AurBuild &build : m_builds) {
+            build.packageFiles = cachedPackageFiles(repository, build);
+            build.cached = !build.packageFiles.isEmpty();
+            if (build.cached)
+                emit output(tr("Using %1 %2 from %3").arg(build.pkgbase, build.version, repository));
+        }
+    }
+
+    QStringList external;
+    for (const AurBuild &build : std::as_const(m_builds)) {
+        if (build.cached)
+            continue;
+        for (const QString &dep : std::as_const(build.makedepends)) {
+            if (produced.contains(dep) && !build.pkgnames.contains(dep)) {
+                // Building one needs another installed first: not independent
+                runSerialFallback(tr("%1 needs %2 to build").arg(build.pkgbase, dep));
+                return;
+            }
+            appendUnique(external, dep);
+        }
+        for (const QString &dep : std::as_const(build.depends)) {
+            if (!produced.contains(dep))
+                appendUnique(external, dep);
+        }
+    }
+
+    const QStringList missing = missingDependencies(external);
+    if (missing.isEmpty()) {
+        m_stage = Stage::Build;
+        startNextBuilds();
+        return;
+    }
+
+    // pacman cannot install dependencies that only exist in the AUR; the
+    // AUR helper builds those first
+    const QStringList aurOnly = unavailableInRepositories(missing);
+    if (!aurOnly.isEmpty()) {
+        runSerialFallback(tr("%1 only available from the AUR").arg(aurOnly.join(", ")));
+        return;
+    }
+
+    m_stage = Stage::InstallDeps;
+    emit output(tr("Installing build dependencies: %1").arg(missing.join(' ')));
+    emit privilegedCommandRequested(QStringList() << "install-deps" << missing);
+}
+
+void AurBuilder::onDepsInstalled(bool ok)
+{
+    if (m_stage != Stage::InstallDeps)
+        return;
+    if (!ok) {
+        finish(false, tr("Failed to install build dependencies"));
+        return;
+    }
+    m_stage = Stage::Build;
+    startNextBuilds();
+}
+
+void AurBuilder::startNextBuilds()
+{
+    m_buildTimers.resize(m_builds.size());
+
+    while (m_runningBuilds < m_maxParallel && m_nextBuild < m_builds.size()) {
+        const int index = m_nextBuild++;
+        const AurBuild &build = m_builds.at(index);
+        if (build.cached)
+            continue;
+
+        emit output(tr("Building %1 %2").arg(build.pkgbase, build.version));
+        m_buildTimers[index].start();
+        ++m_runningBuilds;
+
+        // Dependencies outside the set were verified with pacman -T above;
+        // --nodeps lets split packages depend on siblings not yet installed.
+        launch("makepkg", {"--nodeps", "--noconfirm", "--cleanbuild", "--force"},
+               build.directory, build.pkgbase,
+               [this, index](int exitCode, const QByteArray &) { onBuildFinished(index, exitCode == 0); });
+    }
+
+    // Everything came from the binary repository
+    if (m_runningBuilds == 0 && m_nextBuild >= m_builds.size())
+        publishBuiltPackages();
+}
+
+void AurBuilder::onBuildFinished(int index, bool ok)
+{
+    if (m_stage != Stage::Build)
+        return;
+
+    const AurBuild &build = m_builds.at(index);
+    const qint64 elapsed = m_buildTimers.at(index).elapsed();
+
+    emit packageBuilt(build.pkgbase, ok, elapsed);
+    emit output(tr("[%1] %2 in %3 s")
+                    .arg(build.pkgbase,
+                         ok ? tr("built") : tr("failed"),
+                         QString::number(elapsed / 1000.0, 'f', 1)));
+
+    if (!ok) {
+        finish(false, tr("Building %1 failed").arg(build.pkgbase));
+        return;
+    }
+
+    // Ask makepkg which files it produced; PKGDEST and PKGEXT may be set
+    launch("makepkg", {"--packagelist"}, build.directory, QString(),
+           [this, index](int exitCode, const QByteArray &packageList) {
+               onPackagesListed(index, exitCode == 0 ? packageList : QByteArray());
+           },
+           true);
+}
+
+void AurBuilder::onPackagesListed(int index, const QByteArray &packageList)
+{
+    if (m_stage != Stage::Build)
+        return;
+
+    --m_runningBuilds;
+    AurBuild &build = m_builds[index];
+    build.packageFiles = builtPackageFiles(build, packageList);
+    if (build.packageFiles.isEmpty()) {
+        finish(false, tr("makepkg produced no packages for %1").arg(build.pkgbase));
+        return;
+    }
+
+    if (m_nextBuild < m_builds.size()) {
+        startNextBuilds();
+    } else if (m_runningBuilds == 0) {
+        publishBuiltPackages();
+    }
+}
+
+void AurBuilder::publishBuiltPackages()
+{
+    const QString repository = binaryRepository();
+
+    // A replay only goes through the recorded repo-add
+    const bool replay = SystemAccess::instance().mode() == SystemAccess::Mode::Replay;
+
+    QStringList published;
+    if (!repository.isEmpty() && (replay || QDir().mkpath(repository))) {
+        for (const AurBuild &build : std::as_const(m_builds)) {
+            if (build.cached)
+                continue;
+            for (const QString &file : build.packageFiles) {
+                const QString target = repository + "/" + QFileInfo(file).fileName();
+                if (replay || QFileInfo::exists(target) || QFile::copy(file, target))
+                    published.append(target);
+                else
+                    emit output(tr("Cannot copy %1 to the binary repository").arg(file));
+            }
+        }
+    }
+
+    if (published.isEmpty()) {
+        installBuiltPackages();
+        return;
+    }
+
+    // repo-add takes its own lock, so machines sharing the repository over
+    // a network mount do not corrupt the database. Failing to publish does
+    // not fail the install.
+    m_stage = Stage::Publish;
+    emit output(tr("Publishing %n package(s) to %1", nullptr, int(published.size())).arg(repository));
+    const QString db = repository + "/" + binaryRepositoryName() + ".db.tar.gz";
+    launch("repo-add", QStringList() << "--remove" << db << published, QString(), QString(),
+           [this](int exitCode, const QByteArray &) {
+               if (exitCode != 0)
+                   emit output(tr("Publishing to the binary repository failed (exit code %1)").arg(exitCode));
+               installBuiltPackages();
+           });
+}
+
+void AurBuilder::installBuiltPackages()
+{
+    QStringList files;
+    bool hasDkms = false;
+    for (const AurBuild &build : std::as_const(m_builds)) {
+        files.append(build.packageFiles);
+        for (const QString &pkgname : build.wanted)
+            hasDkms = hasDkms || PackageManager::isDkmsPackage(pkgname);
+    }
+
+    m_stage = Stage::Install;
+    emit output(tr("Installing %n package file(s)", nullptr, int(files.size())));
+
+    QStringList args;
+    args << "install-local";
+    if (hasDkms)
+        args << "--defer-dkms";
+    args << files;
+    emit privilegedCommandRequested(args);
+}
+
+void AurBuilder::privilegedCommandFinished(bool success, int exitCode)
+{
+    if (m_stage == Stage::InstallDeps) {
+        onDepsInstalled(success);
+    } else if (m_stage == Stage::Install) {
+        if (success)
+            finish(true, {});
+        else
+            finish(false, tr("Installing the built packages failed (exit code %1)").arg(exitCode));
+    }
+}
+
+void AurBuilder::runSerialFallback(const QString &reason)
+{
+    emit output(tr("Building serially with %1: %2").arg(m_aurHelper, reason));
+    m_stage = Stage::SerialFallback;
+
+    launch(m_aurHelper, QStringList() << "-S" << "--noconfirm" << "--needed" << m_requested,
+           QString(), QString(),
+           [this](int exitCode, const QByteArray &) {
+               if (exitCode == 0)
+                   finish(true, {});
+               else
+                   finish(false, tr("Operation failed with exit code %1").arg(exitCode));
+           });
+}
+
+void AurBuilder::cancel()
+{
+    if (!isRunning())
+        return;
+    finish(false, tr("Operation was canceled by the user"));
+}
+
+void AurBuilder::finish(bool success, const QString &errorMessage)
+{
+    // Stop anything still running (remaining parallel builds on failure)
+    m_stage = Stage::Idle;
+    for (QTimer *timer : std::as_const(m_replayTimers)) {
+        timer->stop();
+        timer->deleteLater();
+    }
+    m_replayTimers.clear();
+    const QList<QProcess *> processes = m_processes;
+    m_processes.clear();
+    m_partialLines.clear();
+    for (QProcess *process : processes) {
+        process->disconnect(this);
+        if (process->state() != QProcess::NotRunning) {
+            process->kill();
+            process->waitForFinished(3000);
+        }
+        process->deleteLater();
+    }
+
+    emit finished(success, errorMessage);
+}
+
+// =============================================================================
+// Process plumbing
+// =============================================================================
+
+void AurBuilder::launch(const QString &program, const QStringList &args,
+                        const QString &workingDirectory, const QString &prefix,
+                        const Completion &done, bool quiet)
+{
+    SystemAccess &system = SystemAccess::instance();
+    const QStringList key = bundleArguments(args, workingDirectory);
+    const QString linePrefix = prefix.isEmpty() ? QString() : "[" + prefix + "] ";
+
+    if (system.mode() == SystemAccess::Mode::Replay) {
+        // Delivered from a timer, like a process finishing
+        const std::optional<CommandResult> result = system.recordedCommand(program, key);
+        auto *timer = new QTimer(this);
+        timer->setSingleShot(true);
+        m_replayTimers.append(timer);
+        connect(timer, &QTimer::timeout, this, [this, timer, result, linePrefix, quiet, done]() {
+            m_replayTimers.removeOne(timer);
+            timer->deleteLater();
+            if (!result) {
+                done(-1, {});
+                return;
+            }
+            if (!quiet) {
+                for (const QByteArray &line : result->output.split('\n')) {
+                    const QString text = QString::fromUtf8(line).trimmed();
+                    if (!text.isEmpty())
+                        emit output(linePrefix + text);
+                }
+            }
+            done(result->exitCode, result->output);
+        });
+        qDebug() << "AUR builder (replay):" << program << key;
+        timer->start(int(result ? system.replayLatencyMs(*result) : 0));
+        return;
+    }
+
+    auto *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    process->setProcessEnvironment(buildEnvironment());
+    if (!workingDirectory.isEmpty())
+        process->setWorkingDirectory(workingDirectory);
+
+    // Whole output, for the completion and a system-access recording
+    auto captured = std::make_shared<QByteArray>();
+    auto elapsed = std::make_shared<QElapsedTimer>();
+
+    connect(process, &QProcess::readyRead, this, [this, process, linePrefix, quiet, captured]() {
+        const QByteArray data = process->readAll();
+        captured->append(data);
+        if (quiet)
+            return;
+        QByteArray &buffer = m_partialLines[process];
+        buffer.append(data);
+        qsizetype newline;
+        while ((newline = buffer.indexOf('\n')) >= 0) {
+            const QString line = QString::fromUtf8(buffer.first(newline)).trimmed();
+            buffer.remove(0, newline + 1);
+            if (!line.isEmpty())
+                emit output(linePrefix + line);
+        }
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [this, process, program, key, linePrefix, captured, elapsed, done](
+                      int exitCode, QProcess::ExitStatus status) {
+                const QString rest = QString::fromUtf8(m_partialLines.take(process)).trimmed();
+                if (!rest.isEmpty())
+                    emit output(linePrefix + rest);
+                m_processes.removeOne(process);
+                process->deleteLater();
+
+                CommandResult result;
+                result.output = *captured;
+                result.exitCode = status == QProcess::NormalExit ? exitCode : -1;
+                result.durationMs = elapsed->elapsed();
+                SystemAccess::instance().recordCommand(program, key, result);
+                done(result.exitCode, result.output);
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, program](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart && isRunning())
+            finish(false, tr("Failed to start %1").arg(program));
+    });
+
+    m_processes.append(process);
+    qDebug() << "AUR builder:" << program << args << "in" << workingDirectory;
+    elapsed->start();
+    process->start(program, args);
+}
+
+bool AurBuilder::parseSrcinfo(const QString &directory, AurBuild &build)
+{
+    const std::optional<QByteArray> srcinfo = SystemAccess::instance().readFile(directory + "/.SRCINFO");
+    if (!srcinfo)
+        return false;
+
+    const QString arch = QSysInfo::currentCpuArchitecture();
+    QString pkgver, pkgrel, epoch;
+
+    build.directory = directory;
+    const QStringList lines = QString::fromUtf8(*srcinfo).split('\n');
+    for (const QString &raw : lines) {
+        const QString line = raw.trimmed();
+        const qsizetype eq = line.indexOf(" = ");
+        if (eq <= 0)
+            continue;
+        const QString key = line.left(eq);
+        const QString value = line.mid(eq + 3).trimmed();
+
+        if (key == "pkgbase")
+            build.pkgbase = value;
+        else if (key == "pkgname")
+            build.pkgnames.append(value);
+        else if (key == "pkgver")
+            pkgver = value;
+        else if (key == "pkgrel")
+            pkgrel = value;
+        else if (key == "epoch")
+            epoch = value;
+        else if (key == "depends" || key == "depends_" + arch)
+            appendUnique(build.depends, stripConstraint(value));
+        else if (key == "makedepends" || key == "makedepends_" + arch ||
+                 key == "checkdepends" || key == "checkdepends_" + arch)
+            appendUnique(build.makedepends, stripConstraint(value));
+    }
+
+    if (build.pkgbase.isEmpty() || pkgver.isEmpty())
+        return false;
+    build.version = (epoch.isEmpty() ? QString() : epoch + ":") + pkgver + "-" + pkgrel;
+    return true;
+}
+
+QStringList AurBuilder::builtPackageFiles(const AurBuild &build, const QByteArray &packageList)
+{
+    // One path per pkgname; keep only those that should be installed
+    QStringList files;
+    const QStringList paths = QString::fromUtf8(packageList).split('\n', Qt::SkipEmptyParts);
+    for (const QString &raw : paths) {
+        const QString path = raw.trimmed();
+        const QString name = QFileInfo(path).fileName();
+        for (const QString &wanted : build.wanted) {
+            if (name.startsWith(wanted + "-" + build.version + "-") && SystemAccess::instance().exists(path)) {
+                files.append(path);
+                break;
+            }
+        }
+    }
+    return files;
+}
+
+QStringList AurBuilder::cachedPackageFiles(const QString &repository, const AurBuild &build)
+{
+    const QDir dir(repository);
+    const QStringList entries = SystemAccess::instance().entryList(repository);
+    QStringList files;
+    for (const QString &name : build.wanted) {
+        // <pkgname>-<version>-<arch>.pkg.tar.<ext>; the arch part never
+        // contains '-', which rules out pkgnames that merely share a prefix
+        const QString prefix = name + "-" + build.version + "-";
+        QString match;
+        for (const QString &candidate : entries) {
+            if (!candidate.startsWith(prefix) || !candidate.contains(".pkg.tar")
+                || candidate.endsWith(".sig"))
+                continue;
+            const QString arch = candidate.mid(prefix.size()).section(".pkg.tar", 0, 0);
+            if (!arch.contains('-')) {
+                match = dir.absoluteFilePath(candidate);
+                break;
+            }
+        }
+        if (match.isEmpty())
+            return {};
+        files.append(match);
+    }
+    return files;
+}
+
+QStringList AurBuilder::missingDependencies(const QStringList &deps)
+{
+    if (deps.isEmpty())
+        return {};
+
+    // pacman -T prints every dependency that is not satisfied, honouring provides
+    const CommandResult result = SystemAccess::instance().run("pacman", QStringList() << "-T" << deps);
+    return QString::fromUtf8(result.output).split('\n', Qt::SkipEmptyParts);
+}
+
+QStringList AurBuilder::unavailableInRepositories(const QStringList &deps)
+{
+    // One query per dependency: pacman -Sp fails as a whole on any unknown
+    // target. It resolves provides like the install would.
+    QList<CommandSpec> specs;
+    for (const QString &dep : deps)
+        specs.append({"pacman", {"-Sp", "--print-format", "%n", dep}, 10000});
+    const QList<CommandResult> results = ProcessExecutor::instance().runAll(specs);
+
+    QStringList unavailable;
+    for (qsizetype i = 0; i < deps.size(); ++i) {
+        if (results.at(i).exitCode != 0)
+            unavailable.append(deps.at(i));
+    }
+    return unavailable;
+}
@@ -0,0 +1,179 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef AURBUILDER_H
+#define AURBUILDER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+#include <functional>
+
+class QTimer;
+
+/// One AUR pkgbase to build, as described by its .SRCINFO
+struct AurBuild {
+    QString pkgbase;
+    QString directory;          // checkout containing the PKGBUILD
+    QString version;            // [epoch:]pkgver-pkgrel
+    QStringList pkgnames;       // all packages produced by this pkgbase
+    QStringList depends;        // runtime dependencies, constraints stripped
+    QStringList makedepends;    // makedepends + checkdepends, constraints stripped
+    QStringList wanted;         // pkgnames that should be installed
+    QStringList packageFiles;   // built package files to install
+    bool cached = false;        // packageFiles come from the binary repository
+};
+
+/// Builds AUR packages with independent pkgbases in parallel.
+///
+/// PKGBUILDs are fetched with the AUR helper (`-G`), missing repo
+/// dependencies are installed once through the privileged helper, then every
+/// pkgbase is built concurrently with makepkg using a managed makepkg.conf
+/// (MAKEFLAGS=-j$(nproc), ccache when available). The results are installed
+/// in a single pacman transaction.
+///
+/// Root is only needed to install dependencies and results; those helper
+/// commands are handed to the owner through privilegedCommandRequested(),
+/// so they can run in its privileged session.
+///
+/// If one requested package is a build dependency of another, or a
+/// dependency is only in the AUR, the builds are not independent and the
+/// AUR helper is run serially instead (still with the managed makepkg.conf).
+///
+/// Every process and file read goes through SystemAccess, so a build can be
+/// recorded and replayed like the rest of the switch pipeline.
+///
+/// When a local binary repository is configured, packages whose exact
+/// version is already in it are installed from there without building, and
+/// freshly built packages are published back into it with repo-add.
+class AurBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AurBuilder(QObject *parent = nullptr);
+    ~AurBuilder();
+
+    /// AUR helper used to fetch PKGBUILDs and for the serial fallback
+    void setAurHelper(const QString &helper);
+
+    /// Maximum number of makepkg processes running at once
+    void setMaxParallelBuilds(int count);
+
+    /// Directory PKGBUILDs are fetched into ($XDG_CACHE_HOME/rscn-drivers/aur)
+    static QString buildRoot();
+
+    /// Write the managed makepkg.conf and return its path
+    static QString writeManagedMakepkgConf();
+
+    /// Environment for makepkg and AUR helpers, pointing at the managed config
+    static QProcessEnvironment buildEnvironment();
+
+    /// Directory of the local binary repository for built AUR packages, from
+    /// $RSCN_AUR_BINARY_REPO or the "aur/binaryRepository" setting. Accepts a
+    /// plain path or a file:// URL; empty if none is configured.
+    static QString binaryRepository();
+
+    /// Name of the pacman repository database kept in the binary repository
+    static QString binaryRepositoryName() { return QStringLiteral("rscn-aur"); }
+
+    /// Build and install the given AUR packages
+    void start(const QStringList &packages);
+
+    /// Kill all running processes; finished(false) is emitted
+    void cancel();
+
+    bool isRunning() const { return m_stage != Stage::Idle; }
+
+    /// Result of the helper command last requested with
+    /// privilegedCommandRequested()
+    void privilegedCommandFinished(bool success, int exitCode);
+
+signals:
+    /// One line of output; build output is prefixed with "[pkgbase]"
+    void output(const QString &line);
+
+    /// Emitted after each makepkg run with its wall-clock duration
+    void packageBuilt(const QString &pkgbase, bool success, qint64 elapsedMs);
+
+    void finished(bool success, const QString &errorMessage);
+
+    /// Run rscn-drivers-pkhelper with these arguments as root and answer
+    /// with privilegedCommandFinished()
+    void privilegedCommandRequested(const QStringList &helperArgs);
+
+private:
+    enum class Stage {
+        Idle,
+        Fetch,
+        InstallDeps,
+        Build,
+        Publish,
+        Install,
+        SerialFallback
+    };
+
+    /// Exit code (-1 if the process did not finish normally) and output
+    using Completion = std::function<void(int exitCode, const QByteArray &output)>;
+
+    /// Start a tracked process whose output is forwarded line by line,
+    /// unless quiet. When recording, the result is captured; a replay serves
+    /// it from the bundle instead of starting anything.
+    void launch(const QString &program, const QStringList &args,
+                const QString &workingDirectory, const QString &prefix,
+                const Completion &done, bool quiet = false);
+
+    void onFetchFinished(bool ok);
+    void onDepsInstalled(bool ok);
+    void startNextBuilds();
+    void onBuildFinished(int index, bool ok);
+    void onPackagesListed(int index, const QByteArray &packageList);
+    void publishBuiltPackages();
+    void installBuiltPackages();
+    void runSerialFallback(const QString &reason);
+
+    /// Parse one .SRCINFO; returns false if it cannot be read
+    static bool parseSrcinfo(const QString &directory, AurBuild &build);
+
+    /// Files of the build to install, from `makepkg --packagelist` output
+    static QStringList builtPackageFiles(const AurBuild &build, const QByteArray &packageList);
+
+    /// Files in the binary repository matching every wanted pkgname of the
+    /// build at its exact version, or empty if any is missing
+    static QStringList cachedPackageFiles(const QString &repository, const AurBuild &build);
+
+    /// Repo dependencies not satisfied on the system (pacman -T)
+    static QStringList missingDependencies(const QStringList &deps);
+
+    /// Dependencies no sync repository provides, i.e. AUR packages
+    static QStringList unavailableInRepositories(const QStringList &deps);
+
+    void finish(bool success, const QString &errorMessage);
+
+    QString m_aurHelper;
+    int m_maxParallel = 1;
+    Stage m_stage = Stage::Idle;
+    QStringList m_requested;
+
+    QList<AurBuild> m_builds;
+    QList<QElapsedTimer> m_buildTimers;
+    int m_nextBuild = 0;
+    int m_runningBuilds = 0;
+
+    QList<QProcess *> m_processes;
+    QList<QTimer *> m_replayTimers;
+    QHash<QProcess *, QByteArray> m_partialLines;
+};
+
+#endif // AURBUILDER_H
@@ -0,0 +1,155 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "driverhistorymodel.h"
+
+#include <QFuture>
+#include <QLocale>
+#include <QPromise>
+#include <QThreadPool>
+
+namespace {
+
+QString formatDuration(qint64 ms)
+{
+    if (ms < 0)
+        return {};
+    const qint64 seconds = ms / 1000;
+    if (seconds < 60)
+        return QString("%1 s").arg(seconds);
+    return QString("%1 min %2 s").arg(seconds / 60).arg(seconds % 60);
+}
+
+qint64 dkmsDurationMs(const DriverTransaction &transaction)
+{
+    qint64 total = -1;
+    for (const HookRun &hook : transaction.hooks) {
+        if (hook.name.contains("dkms") && hook.durationMs >= 0)
+            total = qMax<qint64>(total, 0) + hook.durationMs;
+    }
+    return total;
+}
+
+} // namespace
+
+DriverHistoryModel::DriverHistoryModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_analyzer(std::make_shared<PacmanLogAnalyzer>())
+{
+}
+
+int DriverHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_rows.size());
+}
+
+int DriverHistoryModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant DriverHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return {};
+
+    const Row &row = m_rows.at(index.row());
+    const DriverTransaction &transaction = m_transactions.at(row.transaction);
+    const PackageChange *change = row.change >= 0 ? &transaction.changes.at(row.change) : nullptr;
+
+    switch (index.column()) {
+    case Time:
+        return QLocale().toString(transaction.started, QLocale::ShortFormat);
+    case Action:
+        return change ? PacmanLogAnalyzer::actionName(change->action) : tr("DKMS rebuild");
+    case Package:
+        return change ? change->package : transaction.command;
+    case Version:
+        if (!change)
+            return {};
+        if (change->action == PackageChange::Action::Upgraded
+            || change->action == PackageChange::Action::Downgraded)
+            return QString("%1 → %2").arg(change->oldVersion, change->newVersion);
+        return change->newVersion.isEmpty() ? change->oldVersion : change->newVersion;
+    case TransactionTime:
+        return formatDuration(transaction.durationMs);
+    case DkmsTime:
+        return formatDuration(dkmsDurationMs(transaction));
+    }
+    return {};
+}
+
+QVariant DriverHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return {};
+
+    switch (section) {
+    case Time:            return tr("Date");
+    case Action:          return tr("Action");
+    case Package:         return tr("Package");
+    case Version:         return tr("Version");
+    case TransactionTime: return tr("Transaction");
+    case DkmsTime:        return tr("DKMS");
+    }
+    return {};
+}
+
+const DriverTransaction &DriverHistoryModel::transactionAt(int row) const
+{
+    return m_transactions.at(m_rows.at(row).transaction);
+}
+
+void DriverHistoryModel::refresh()
+{
+    // The analyzer is not thread-safe; one parse at a time, and a refresh
+    // asked for meanwhile runs once it is done
+    if (m_refreshing) {
+        m_refreshAgain = true;
+        return;
+    }
+    m_refreshing = true;
+
+    auto promise = std::make_shared<QPromise<QList<DriverTransaction>>>();
+    QFuture<QList<DriverTransaction>> future = promise->future();
+    promise->start();
+
+    QThreadPool::globalInstance()->start([promise, analyzer = m_analyzer]() {
+        promise->addResult(analyzer->history());
+        promise->finish();
+    });
+
+    future.then(this, [this](const QList<DriverTransaction> &transactions) {
+        setTransactions(transactions);
+        m_refreshing = false;
+        emit refreshed();
+        if (m_refreshAgain) {
+            m_refreshAgain = false;
+            refresh();
+        }
+    });
+}
+
+void DriverHistoryModel::setTransactions(const QList<DriverTransaction> &transactions)
+{
+    beginResetModel();
+    m_transactions = transactions;
+    m_rows.clear();
+    for (int t = int(m_transactions.size()) - 1; t >= 0; --t) {
+        const DriverTransaction &transaction = m_transactions.at(t);
+        if (transaction.changes.isEmpty()) {
+            m_rows.append({t, -1});
+            continue;
+        }
+        for (int c = 0; c < transaction.changes.size(); ++c)
+            m_rows.append({t, c});
+    }
+    endResetModel();
+}
@@ -0,0 +1,68 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef DRIVERHISTORYMODEL_H
+#define DRIVERHISTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QList>
+
+#include <memory>
+
+#include "pacmanloganalyzer.h"
+
+/// Table model of driver package changes from pacman.log, one row per
+/// change, newest first. Each row also shows how long its transaction and
+/// DKMS hooks took. DKMS rebuilds without a driver package change (kernel
+/// updates) get a row of their own.
+class DriverHistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { Time, Action, Package, Version, TransactionTime, DkmsTime, ColumnCount };
+
+    explicit DriverHistoryModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    /// Transaction a row belongs to, e.g. for PacmanLogAnalyzer::excerpt
+    const DriverTransaction &transactionAt(int row) const;
+
+public slots:
+    /// Pick up what pacman logged since the last refresh; cheap enough to
+    /// call after every operation. The log is parsed on the global thread
+    /// pool and the rows are replaced once it is done.
+    void refresh();
+
+signals:
+    /// The rows reflect the log as of the last refresh()
+    void refreshed();
+
+private:
+    void setTransactions(const QList<DriverTransaction> &transactions);
+
+    struct Row {
+        int transaction;   // index into m_transactions
+        int change;        // index into its changes, -1 for a DKMS-only row
+    };
+
+    // Shared with the worker, which may outlive the model
+    std::shared_ptr<PacmanLogAnalyzer> m_analyzer;
+    bool m_refreshing = false;
+    bool m_refreshAgain = false;   // refresh() was called while parsing
+    QList<DriverTransaction> m_transactions;
+    QList<Row> m_rows;
+};
+
+#endif // DRIVERHISTORYMODEL_H
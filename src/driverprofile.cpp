@@ -10,6 +10,11 @@
 
 #include "driverprofile.h"
 
+#include <QCoreApplication>
+#include <QHash>
+
+#include <algorithm>
+
 // ---------------------------------------------------------------------------
 // Intel profiles
 // ---------------------------------------------------------------------------
@@ -26,12 +31,13 @@ QList<DriverProfile> DriverProfileManager::buildIntelProfiles()
         p.optionalPackages = {"lib32-mesa", "lib32-vulkan-intel"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::OpenSource;
-        p.recommended = true;
+        p.preference = 100;
         p.vendor = "Intel";
-        p.description = "Open-source Mesa/Vulkan driver for Intel HD/UHD/Iris/Arc GPUs (Broadwell and newer). Recommended.";
+        p.description = "Open-source Mesa/Vulkan driver for Intel HD/UHD/Iris/Arc GPUs (Broadwell and newer).";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::IntelBroadwellPlus, GpuArch::IntelArc};
+        p.earlyKmsModules = {"i915"};
         profiles.append(p);
     }
 
@@ -44,12 +50,13 @@ QList<DriverProfile> DriverProfileManager::buildIntelProfiles()
         p.optionalPackages = {"lib32-mesa", "xf86-video-intel"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::OpenSource;
-        p.recommended = false;
+        p.preference = 100;
         p.vendor = "Intel";
         p.description = "Open-source Mesa driver for older Intel GPUs (pre-Broadwell, GMA series).";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::IntelLegacy};
+        p.earlyKmsModules = {"i915"};
         profiles.append(p);
     }
 
@@ -72,12 +79,13 @@ QList<DriverProfile> DriverProfileManager::buildAmdProfiles()
         p.optionalPackages = {"lib32-mesa", "lib32-vulkan-radeon"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::OpenSource;
-        p.recommended = true;
+        p.preference = 100;
         p.vendor = "AMD";
-        p.description = "Open-source AMDGPU kernel driver with Mesa Vulkan. Recommended for GCN and newer.";
+        p.description = "Open-source AMDGPU kernel driver with Mesa Vulkan, for GCN and newer.";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::AmdGcn, GpuArch::AmdRdna, GpuArch::AmdIntegrated};
+        p.earlyKmsModules = {"amdgpu"};
         profiles.append(p);
     }
 
@@ -90,12 +98,13 @@ QList<DriverProfile> DriverProfileManager::buildAmdProfiles()
         p.optionalPackages = {"lib32-mesa"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::OpenSource;
-        p.recommended = false;
+        p.preference = 100;
         p.vendor = "AMD";
         p.description = "Open-source ATI driver for pre-GCN AMD/ATI GPUs.";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::AmdPreGcn};
+        p.earlyKmsModules = {"radeon"};
         profiles.append(p);
     }
 
@@ -108,12 +117,13 @@ QList<DriverProfile> DriverProfileManager::buildAmdProfiles()
         p.optionalPackages = {"opencl-amd"};
         p.source = PackageSource::AUR;
         p.type = DriverType::Proprietary;
-        p.recommended = false;
+        p.preference = 40;
         p.vendor = "AMD";
         p.description = "Proprietary AMDGPU PRO driver from AUR. For OpenCL support or professional applications.";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::AmdGcn, GpuArch::AmdRdna, GpuArch::AmdIntegrated};
+        p.earlyKmsModules = {"amdgpu"};
         profiles.append(p);
     }
 
@@ -136,14 +146,16 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.optionalPackages = {"lib32-nvidia-utils", "nvidia-settings"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::Proprietary;
-        p.recommended = true;
+        p.preference = 100;
         p.vendor = "NVIDIA";
-        p.description = "Proprietary NVIDIA driver using DKMS. Recommended for Maxwell (GTX 900) and newer.";
+        p.description = "Proprietary NVIDIA driver using DKMS, for Maxwell (GTX 900) and newer. Works with any kernel, including custom ones.";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::NvidiaMaxwell, GpuArch::NvidiaPascal,
                             GpuArch::NvidiaTuring, GpuArch::NvidiaAmpere,
                             GpuArch::NvidiaAdaLovelace};
+        p.earlyKmsModules = {"nvidia", "nvidia_modeset", "nvidia_uvm", "nvidia_drm"};
+        p.kernelParameters = {"nvidia-drm.modeset=1"};
         profiles.append(p);
     }
 
@@ -156,7 +168,7 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.optionalPackages = {"lib32-nvidia-utils", "nvidia-settings"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::Proprietary;
-        p.recommended = false;
+        p.preference = 100;
         p.vendor = "NVIDIA";
         p.description = "Proprietary NVIDIA driver for the standard linux kernel. Use nvidia-dkms for custom kernels.";
         p.active = false;
@@ -164,6 +176,9 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.supportedArchs = {GpuArch::NvidiaMaxwell, GpuArch::NvidiaPascal,
                             GpuArch::NvidiaTuring, GpuArch::NvidiaAmpere,
                             GpuArch::NvidiaAdaLovelace};
+        p.earlyKmsModules = {"nvidia", "nvidia_modeset", "nvidia_uvm", "nvidia_drm"};
+        p.kernelParameters = {"nvidia-drm.modeset=1"};
+        p.kernelPackages = {"linux"};
         profiles.append(p);
     }
 
@@ -176,7 +191,7 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.optionalPackages = {"lib32-nvidia-utils", "nvidia-settings"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::Proprietary;
-        p.recommended = false;
+        p.preference = 100;
         p.vendor = "NVIDIA";
         p.description = "Proprietary NVIDIA driver for the linux-lts kernel.";
         p.active = false;
@@ -184,6 +199,9 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.supportedArchs = {GpuArch::NvidiaMaxwell, GpuArch::NvidiaPascal,
                             GpuArch::NvidiaTuring, GpuArch::NvidiaAmpere,
                             GpuArch::NvidiaAdaLovelace};
+        p.earlyKmsModules = {"nvidia", "nvidia_modeset", "nvidia_uvm", "nvidia_drm"};
+        p.kernelParameters = {"nvidia-drm.modeset=1"};
+        p.kernelPackages = {"linux-lts"};
         profiles.append(p);
     }
 
@@ -196,12 +214,14 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.optionalPackages = {"lib32-nvidia-470xx-utils"};
         p.source = PackageSource::AUR;
         p.type = DriverType::Proprietary;
-        p.recommended = false;
+        p.preference = 100;
         p.vendor = "NVIDIA";
         p.description = "Legacy NVIDIA driver from AUR for GeForce 600/700 series (Kepler).";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {GpuArch::NvidiaKepler};
+        p.earlyKmsModules = {"nvidia", "nvidia_modeset", "nvidia_uvm", "nvidia_drm"};
+        p.kernelParameters = {"nvidia-drm.modeset=1"};
         profiles.append(p);
     }
 
@@ -214,12 +234,182 @@ QList<DriverProfile> DriverProfileManager::buildNvidiaProfiles()
         p.optionalPackages = {"lib32-mesa"};
         p.source = PackageSource::Pacman;
         p.type = DriverType::OpenSource;
-        p.recommended = false;
+        p.preference = 30;
         p.vendor = "NVIDIA";
         p.description = "Open-source Nouveau driver. Lower performance, no advanced GPU features. Fallback option.";
         p.active = false;
         p.installStatus = InstallStatus::NotInstalled;
         p.supportedArchs = {};  // empty = all NVIDIA architectures
+        p.earlyKmsModules = {"nouveau"};
+        profiles.append(p);
+    }
+
+    return profiles;
+}
+
+// ---------------------------------------------------------------------------
+// Network profiles
+// ---------------------------------------------------------------------------
+QList<DriverProfile> DriverProfileManager::buildNetworkProfiles()
+{
+    QList<DriverProfile> profiles;
+
+    // Broadcom chips without b43/brcmfmac support
+    const QStringList broadcomWlIds = {
+        "14e4:4311", "14e4:4312", "14e4:4313", "14e4:4315", "14e4:4328",
+        "14e4:432b", "14e4:4331", "14e4:4353", "14e4:4357", "14e4:4358",
+        "14e4:4359", "14e4:4365", "14e4:43a0", "14e4:43b1"
+    };
+
+    // Broadcom wl, prebuilt for the default kernel
+    {
+        DriverProfile p;
+        p.id = "broadcom-wl";
+        p.displayName = "Broadcom wl (Proprietary)";
+        p.requiredPackages = {"broadcom-wl"};
+        p.source = PackageSource::Pacman;
+        p.type = DriverType::Proprietary;
+        p.preference = 100;
+        p.vendor = "Broadcom";
+        p.description = "Proprietary Broadcom 802.11 driver, prebuilt for the linux kernel.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.kernelPackages = {"linux"};
+        p.supportedPciIds = broadcomWlIds;
+        p.kernelModule = "wl";
+        profiles.append(p);
+    }
+
+    // Broadcom wl, built by DKMS for any kernel
+    {
+        DriverProfile p;
+        p.id = "broadcom-wl-dkms";
+        p.displayName = "Broadcom wl DKMS (Proprietary)";
+        p.requiredPackages = {"broadcom-wl-dkms"};
+        p.source = PackageSource::Pacman;
+        p.type = DriverType::Proprietary;
+        p.preference = 100;
+        p.vendor = "Broadcom";
+        p.description = "Proprietary Broadcom 802.11 driver built with DKMS. Works with any installed kernel.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.supportedPciIds = broadcomWlIds;
+        p.kernelModule = "wl";
+        profiles.append(p);
+    }
+
+    // Realtek RTL8821CE (not covered by the in-kernel rtw88 on older kernels)
+    {
+        DriverProfile p;
+        p.id = "rtl8821ce-dkms";
+        p.displayName = "Realtek RTL8821CE DKMS";
+        p.requiredPackages = {"rtl8821ce-dkms-git"};
+        p.source = PackageSource::AUR;
+        p.type = DriverType::OpenSource;
+        p.preference = 60;
+        p.vendor = "Realtek";
+        p.description = "Out-of-tree Realtek RTL8821CE wireless driver from AUR. Use if rtw88 is unstable.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.supportedPciIds = {"10ec:c821"};
+        p.kernelModule = "8821ce";
+        p.inKernelModules = {"rtw_8821ce"};
+        profiles.append(p);
+    }
+
+    // Realtek RTL8111/8168 ethernet, vendor driver prebuilt for the default kernel
+    {
+        DriverProfile p;
+        p.id = "r8168";
+        p.displayName = "Realtek r8168";
+        p.requiredPackages = {"r8168"};
+        p.source = PackageSource::Pacman;
+        p.type = DriverType::OpenSource;
+        p.preference = 60;
+        p.vendor = "Realtek";
+        p.description = "Realtek vendor driver for RTL8111/8168 ethernet, for the linux kernel. Use if r8169 is unreliable.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.kernelPackages = {"linux"};
+        p.supportedPciIds = {"10ec:8168"};
+        p.kernelModule = "r8168";
+        p.inKernelModules = {"r8169"};
+        profiles.append(p);
+    }
+
+    // Realtek r8168 for the LTS kernel
+    {
+        DriverProfile p;
+        p.id = "r8168-lts";
+        p.displayName = "Realtek r8168 (LTS Kernel)";
+        p.requiredPackages = {"r8168-lts"};
+        p.source = PackageSource::Pacman;
+        p.type = DriverType::OpenSource;
+        p.preference = 60;
+        p.vendor = "Realtek";
+        p.description = "Realtek vendor driver for RTL8111/8168 ethernet, for the linux-lts kernel.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.kernelPackages = {"linux-lts"};
+        p.supportedPciIds = {"10ec:8168"};
+        p.kernelModule = "r8168";
+        p.inKernelModules = {"r8169"};
+        profiles.append(p);
+    }
+
+    // Realtek r8168 built by DKMS
+    {
+        DriverProfile p;
+        p.id = "r8168-dkms";
+        p.displayName = "Realtek r8168 DKMS";
+        p.requiredPackages = {"r8168-dkms"};
+        p.source = PackageSource::AUR;
+        p.type = DriverType::OpenSource;
+        p.preference = 60;
+        p.vendor = "Realtek";
+        p.description = "Realtek vendor driver for RTL8111/8168 ethernet from AUR, built with DKMS for any kernel.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.supportedPciIds = {"10ec:8168"};
+        p.kernelModule = "r8168";
+        p.inKernelModules = {"r8169"};
+        profiles.append(p);
+    }
+
+    // Realtek RTL88x2BU USB adapters, for kernels before rtw88 gained USB support
+    {
+        DriverProfile p;
+        p.id = "rtl88x2bu-dkms";
+        p.displayName = "Realtek RTL88x2BU DKMS (USB)";
+        p.requiredPackages = {"rtl88x2bu-dkms-git"};
+        p.source = PackageSource::AUR;
+        p.type = DriverType::OpenSource;
+        p.preference = 60;
+        p.vendor = "Realtek";
+        p.description = "Out-of-tree driver for RTL8812BU/RTL8822BU USB Wi-Fi adapters from AUR. Use if rtw88_8822bu is unstable.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.supportedUsbIds = {"0bda:b812", "0bda:b82c", "2357:012d", "2357:0115", "0b05:1841", "7392:b822"};
+        p.kernelModule = "88x2bu";
+        p.inKernelModules = {"rtw_8822bu"};
+        profiles.append(p);
+    }
+
+    // Realtek RTL8812AU/8821AU USB adapters (no in-kernel driver)
+    {
+        DriverProfile p;
+        p.id = "rtl8812au-dkms";
+        p.displayName = "Realtek RTL8812AU DKMS (USB)";
+        p.requiredPackages = {"rtl8812au-dkms-git"};
+        p.source = PackageSource::AUR;
+        p.type = DriverType::OpenSource;
+        p.preference = 100;
+        p.vendor = "Realtek";
+        p.description = "Out-of-tree driver for RTL8812AU/RTL8821AU USB Wi-Fi adapters from AUR.";
+        p.active = false;
+        p.installStatus = InstallStatus::NotInstalled;
+        p.supportedUsbIds = {"0bda:8812", "0bda:881a", "0bda:0811", "2357:0101", "2357:0103", "0b05:17d2"};
+        p.kernelModule = "88XXau";
         profiles.append(p);
     }
 
@@ -246,9 +436,45 @@ QList<DriverProfile> DriverProfileManager::getAllProfiles()
     all.append(buildIntelProfiles());
     all.append(buildAmdProfiles());
     all.append(buildNvidiaProfiles());
+    all.append(buildNetworkProfiles());
     return all;
 }
 
+QList<DriverProfile> DriverProfileManager::getNetworkProfiles()
+{
+    return buildNetworkProfiles();
+}
+
+namespace {
+
+/// Kernel ranges of the out-of-tree modules the profiles install. Repo
+/// packages mostly encode this in their depends; the table covers DKMS and
+/// AUR packages, whose build only fails after download and compilation.
+/// Update it together with the driver releases it describes.
+const KernelCompatibility kKernelCompatibility[] = {
+    // Legacy Kepler branch: receives compatibility patches only, and lags
+    // behind mainline
+    {"nvidia-470xx-dkms",  "3.10", "6.12"},
+    // Current branch
+    {"nvidia-dkms",         "4.15", ""},
+    // Realtek out-of-tree wireless and ethernet drivers
+    {"rtl8821ce-dkms-git",  "4.14", ""},
+    {"rtl88x2bu-dkms-git",  "4.14", ""},
+    {"rtl8812au-dkms-git",  "4.14", ""},
+    {"r8168-dkms",          "4.14", ""},
+};
+
+} // namespace
+
+std::optional<KernelCompatibility> DriverProfileManager::kernelCompatibility(const QString &package)
+{
+    for (const KernelCompatibility &entry : kKernelCompatibility) {
+        if (entry.package == package)
+            return entry;
+    }
+    return std::nullopt;
+}
+
 QList<DriverProfile> DriverProfileManager::getProfilesForDevice(
     const GpuDevice &device,
     PackageManager &packageManager)
@@ -265,27 +491,258 @@ QList<DriverProfile> DriverProfileManager::getProfilesForDevice(
         }
 
         profile.installStatus = checkInstallStatus(profile, packageManager);
-        profile.active = isDriverActive(profile, device);
+        resolveFirmware(profile, packageManager);
+        profile.active = isDriverActive(profile, device, packageManager);
+        filtered.append(profile);
+    }
+
+    rankProfiles(filtered, HardwareDetector::installedKernels(), packageManager);
+    return filtered;
+}
+
+QList<DriverProfile> DriverProfileManager::getProfilesForNetworkDevice(
+    const NetworkDevice &device,
+    PackageManager &packageManager)
+{
+    if (device.pciId.isEmpty())
+        return {};
+
+    QList<DriverProfile> filtered;
+    for (auto &profile : buildNetworkProfiles()) {
+        if (!profile.supportedPciIds.contains(device.pciId))
+            continue;
+
+        profile.installStatus = checkInstallStatus(profile, packageManager);
+        resolveFirmware(profile, packageManager);
+        profile.active = isModuleActive(profile, device.kernelDriver, packageManager);
         filtered.append(profile);
     }
 
-    // If the legacy profile is the right match, mark it as recommended instead of the modern one
-    // (e.g., Intel legacy GPU should recommend intel-legacy, not intel-modern)
-    bool hasRecommendedActive = false;
-    for (const auto &p : filtered) {
-        if (p.recommended)
-            hasRecommendedActive = true;
+    if (!filtered.isEmpty()) {
+        rankProfiles(filtered, HardwareDetector::installedKernels(), packageManager);
+        preferBoundInKernelDriver(filtered, device.kernelDriver);
     }
+    return filtered;
+}
+
+QList<DriverProfile> DriverProfileManager::getProfilesForUsbDevice(
+    const UsbDevice &device,
+    PackageManager &packageManager)
+{
+    QList<DriverProfile> filtered;
+    for (auto &profile : buildNetworkProfiles()) {
+        if (!profile.supportedUsbIds.contains(device.usbId))
+            continue;
 
-    // If no recommended profile matched the architecture filter,
-    // promote the first available profile to recommended
-    if (!hasRecommendedActive && !filtered.isEmpty()) {
-        filtered[0].recommended = true;
+        profile.installStatus = checkInstallStatus(profile, packageManager);
+        resolveFirmware(profile, packageManager);
+        profile.active = isModuleActive(profile, device.kernelDriver, packageManager);
+        filtered.append(profile);
     }
 
+    if (!filtered.isEmpty()) {
+        rankProfiles(filtered, HardwareDetector::installedKernels(), packageManager);
+        preferBoundInKernelDriver(filtered, device.kernelDriver);
+    }
     return filtered;
 }
 
+// ---------------------------------------------------------------------------
+// Recommendation scoring
+// ---------------------------------------------------------------------------
+namespace {
+
+/// Some package cannot be installed (not in the repos, or AUR without a helper)
+constexpr int kUnavailablePenalty = 1000;
+
+/// An installed kernel would boot without the driver's module
+constexpr int kUncoveredKernelPenalty = 1000;
+
+/// Modules are compiled for each kernel on install and every kernel update
+constexpr int kDkmsBuildPenaltyPerKernel = 15;
+
+/// Packages are built locally from the AUR
+constexpr int kAurBuildPenalty = 20;
+
+/// Already fully installed: choosing it requires no transaction
+constexpr int kInstalledBonus = 5;
+
+} // namespace
+
+int DriverProfileManager::scoreProfile(
+    const DriverProfile &profile,
+    const QStringList &installedKernels,
+    PackageManager &packageManager)
+{
+    int score = profile.preference;
+
+    // Prebuilt modules only exist for their own kernels; every installed
+    // kernel must be covered. An unknown kernel set covers nothing.
+    if (!profile.kernelPackages.isEmpty()) {
+        for (const QString &kernel : installedKernels) {
+            if (!profile.kernelPackages.contains(kernel)) {
+                score -= kUncoveredKernelPenalty;
+                break;
+            }
+        }
+        if (installedKernels.isEmpty())
+            score -= kUncoveredKernelPenalty;
+    }
+
+    const bool dkms = std::any_of(profile.requiredPackages.cbegin(), profile.requiredPackages.cend(),
+                                  &PackageManager::isDkmsPackage);
+    if (dkms)
+        score -= kDkmsBuildPenaltyPerKernel * std::max<qsizetype>(1, installedKernels.size());
+
+    if (profile.installStatus == InstallStatus::FullyInstalled)
+        return score + kInstalledBonus;
+
+    if (profile.source == PackageSource::AUR) {
+        score -= kAurBuildPenalty;
+        if (packageManager.findAurHelper().isEmpty())
+            score -= kUnavailablePenalty;
+        return score;
+    }
+
+    for (const QString &pkg : packageManager.filterNotInstalled(profile.requiredPackages)) {
+        if (!packageManager.isPackageAvailable(pkg)) {
+            score -= kUnavailablePenalty;
+            break;
+        }
+    }
+    return score;
+}
+
+void DriverProfileManager::rankProfiles(
+    QList<DriverProfile> &profiles,
+    const QStringList &installedKernels,
+    PackageManager &packageManager)
+{
+    int best = -1;
+    for (int i = 0; i < profiles.size(); ++i) {
+        profiles[i].score = scoreProfile(profiles[i], installedKernels, packageManager);
+        profiles[i].recommended = false;
+        // Ties go to the profile listed first
+        if (best < 0 || profiles[i].score > profiles[best].score)
+            best = i;
+    }
+
+    if (best >= 0)
+        profiles[best].recommended = true;
+}
+
+void DriverProfileManager::preferBoundInKernelDriver(
+    QList<DriverProfile> &profiles,
+    const QString &kernelDriver)
+{
+    // e.g. r8169 driving an RTL8111: the vendor r8168 is only worth it if
+    // r8169 misbehaves, which the user has to decide
+    if (kernelDriver.isEmpty())
+        return;
+    for (DriverProfile &profile : profiles) {
+        if (profile.inKernelModules.contains(kernelDriver))
+            profile.recommended = false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Profile switching
+// ---------------------------------------------------------------------------
+ProfileSwitchPlan DriverProfileManager::planSwitch(
+    const DriverProfile &from,
+    const DriverProfile &to,
+    PackageManager &packageManager,
+    const QStringList &protectedPackages)
+{
+    ProfileSwitchPlan plan;
+
+    // Only what pacman cannot satisfy yet, counting provides (e.g. an
+    // installed mesa-git satisfies "mesa", and the linux-firmware
+    // metapackage pulls in every split firmware package)
+    QStringList targetPackages = to.requiredPackages;
+    for (const QString &pkg : to.firmwarePackages) {
+        if (!targetPackages.contains(pkg))
+            targetPackages.append(pkg);
+    }
+    plan.install = packageManager.unsatisfiedDependencies(targetPackages);
+
+    // Relations of the installed old packages, each queried once; conflicts
+    // only matter if something gets installed
+    const QStringList installedOld = packageManager.filterInstalled(from.requiredPackages);
+    QHash<QString, QStringList> oldProvides;
+    QHash<QString, QStringList> oldConflicts;
+    for (const QString &pkg : installedOld) {
+        oldProvides.insert(pkg, packageManager.packageRelations(pkg, "Provides", true));
+        if (!plan.install.isEmpty())
+            oldConflicts.insert(pkg, packageManager.packageRelations(pkg, "Conflicts With", true));
+    }
+
+    // Old packages: shared ones stay, as do ones providing a new requirement
+    for (const QString &pkg : installedOld) {
+        if (to.requiredPackages.contains(pkg) || protectedPackages.contains(pkg)) {
+            plan.keep.append(pkg);
+            continue;
+        }
+        const QStringList &provides = oldProvides[pkg];
+        const bool satisfiesTarget = std::any_of(provides.cbegin(), provides.cend(),
+            [&to](const QString &name) { return to.requiredPackages.contains(name); });
+        if (satisfiesTarget)
+            plan.keep.append(pkg);
+        else
+            plan.remove.append(pkg);
+    }
+
+    // Conflicts in either direction make pacman replace the old package
+    // during the install step (e.g. nvidia-dkms for nvidia)
+    for (const QString &newPkg : std::as_const(plan.install)) {
+        const QStringList newConflicts = packageManager.packageRelations(newPkg, "Conflicts With", false);
+        const QStringList newProvides = packageManager.packageRelations(newPkg, "Provides", false);
+
+        for (const QString &oldPkg : installedOld) {
+            if (plan.replaced.contains(oldPkg))
+                continue;
+
+            const QStringList &provides = oldProvides[oldPkg];
+            const QStringList &conflictsWith = oldConflicts[oldPkg];
+            const bool conflicts = newConflicts.contains(oldPkg)
+                || std::any_of(provides.cbegin(), provides.cend(),
+                       [&newConflicts](const QString &name) { return newConflicts.contains(name); })
+                || conflictsWith.contains(newPkg)
+                || std::any_of(newProvides.cbegin(), newProvides.cend(),
+                       [&conflictsWith](const QString &name) { return conflictsWith.contains(name); });
+            if (!conflicts)
+                continue;
+
+            if (protectedPackages.contains(oldPkg)) {
+                plan.error = QCoreApplication::translate("DriverProfileManager",
+                    "%1 conflicts with %2, which is still needed by another device")
+                    .arg(newPkg, oldPkg);
+                return plan;
+            }
+            plan.replaced.append(oldPkg);
+            plan.keep.removeAll(oldPkg);
+            if (!plan.remove.contains(oldPkg))
+                plan.remove.append(oldPkg);
+        }
+    }
+
+    return plan;
+}
+
+void DriverProfileManager::resolveFirmware(
+    DriverProfile &profile,
+    PackageManager &packageManager)
+{
+    QStringList modules = profile.earlyKmsModules;
+    if (!profile.kernelModule.isEmpty() && !modules.contains(profile.kernelModule))
+        modules.append(profile.kernelModule);
+
+    QStringList files;
+    for (const QString &module : std::as_const(modules))
+        files.append(packageManager.moduleFirmware(module));
+    profile.firmwarePackages = packageManager.firmwarePackages(files);
+}
+
 InstallStatus DriverProfileManager::checkInstallStatus(
     const DriverProfile &profile,
     PackageManager &packageManager)
@@ -293,11 +750,7 @@ InstallStatus DriverProfileManager::checkInstallStatus(
     if (profile.requiredPackages.isEmpty())
         return InstallStatus::NotInstalled;
 
-    int installedCount = 0;
-    for (const QString &pkg : profile.requiredPackages) {
-        if (packageManager.isPackageInstalled(pkg))
-            ++installedCount;
-    }
+    const qsizetype installedCount = packageManager.filterInstalled(profile.requiredPackages).size();
 
     if (installedCount == 0)
         return InstallStatus::NotInstalled;
@@ -308,18 +761,25 @@ InstallStatus DriverProfileManager::checkInstallStatus(
 
 bool DriverProfileManager::isDriverActive(
     const DriverProfile &profile,
-    const GpuDevice &device)
+    const GpuDevice &device,
+    PackageManager &packageManager)
 {
     const QString &driver = device.kernelDriver;
 
-    // For NVIDIA proprietary profiles, the kernel driver is "nvidia".
-    // We need to disambiguate by checking which package is actually installed.
-    if (profile.id == "nvidia-proprietary" || profile.id == "nvidia-standard" || profile.id == "nvidia-lts") {
-        // Active only if the kernel driver is nvidia AND this specific profile is fully installed
-        return driver == "nvidia" && profile.installStatus == InstallStatus::FullyInstalled;
-    }
-    if (profile.id == "nvidia-470xx") {
-        return driver == "nvidia" && profile.installStatus == InstallStatus::FullyInstalled;
+    // All NVIDIA proprietary profiles load a module named "nvidia", and more
+    // than one of them may be installed at the same time. The package that
+    // owns the loaded module identifies the profile actually in use.
+    if (profile.id == "nvidia-proprietary" || profile.id == "nvidia-standard" ||
+        profile.id == "nvidia-lts" || profile.id == "nvidia-470xx") {
+        if (driver != "nvidia")
+            return false;
+
+        const QString owner = packageManager.kernelModuleOwner(driver);
+        if (!owner.isEmpty())
+            return profile.requiredPackages.contains(owner);
+
+        // Module owner could not be resolved; fall back to install state
+        return profile.installStatus == InstallStatus::FullyInstalled;
     }
     if (profile.id == "nvidia-nouveau") {
         return driver == "nouveau";
@@ -343,3 +803,19 @@ bool DriverProfileManager::isDriverActive(
 
     return false;
 }
+
+bool DriverProfileManager::isModuleActive(
+    const DriverProfile &profile,
+    const QString &kernelDriver,
+    PackageManager &packageManager)
+{
+    if (profile.kernelModule.isEmpty() || kernelDriver != profile.kernelModule)
+        return false;
+
+    // Prebuilt and DKMS variants load the same module; the package owning
+    // the loaded one tells them apart
+    const QString owner = packageManager.kernelModuleOwner(kernelDriver);
+    if (!owner.isEmpty())
+        return profile.requiredPackages.contains(owner);
+    return profile.installStatus == InstallStatus::FullyInstalled;
+}
@@ -15,6 +15,8 @@
 #include <QStringList>
 #include <QList>
 
+#include <optional>
+
 #include "hardwaredetector.h"
 #include "packagemanager.h"
 
@@ -41,12 +43,41 @@ struct DriverProfile {
     QStringList optionalPackages;   // packages that are optional
     PackageSource source;          // pacman or AUR
     DriverType type;               // open-source or proprietary
-    bool recommended;              // whether this is the recommended driver
-    QString vendor;                // "Intel", "AMD", "NVIDIA"
+    int preference;                // base desirability among profiles fitting the architecture
+    QString vendor;                // "Intel", "AMD", "NVIDIA", or a network chip vendor
     QString description;           // brief description
     bool active;                   // whether this driver is currently in use
     InstallStatus installStatus;   // current install state
     QList<GpuArch> supportedArchs; // GPU architectures this profile applies to (empty = all for vendor)
+    QStringList earlyKmsModules;   // kernel modules to load from the initramfs for early KMS
+    QStringList kernelPackages;    // kernels the prebuilt modules are for (empty = any kernel)
+    QStringList kernelParameters;  // kernel command-line parameters the driver needs
+    QStringList supportedPciIds;   // vendor:device IDs this profile applies to (network profiles)
+    QStringList supportedUsbIds;   // vendor:product IDs of USB adapters it applies to
+    QString kernelModule;          // module the driver binds with (network profiles)
+    QStringList inKernelModules;   // in-kernel drivers it replaces, as bound in sysfs (network profiles)
+    QStringList firmwarePackages;  // split linux-firmware packages its modules need
+    int score = 0;                 // recommendation score, see DriverProfileManager::rankProfiles
+    bool recommended = false;      // highest-scoring profile for the device
+};
+
+/// Kernel series a driver package is known to build and load against.
+/// Bounds are "major.minor" series and inclusive; empty means unbounded.
+struct KernelCompatibility {
+    QString package;    // driver package, e.g. "nvidia-470xx-dkms"
+    QString minKernel;  // oldest supported series, e.g. "4.15"
+    QString maxKernel;  // newest supported series, e.g. "6.12"
+};
+
+/// Package delta for switching from one profile to another
+struct ProfileSwitchPlan {
+    QStringList install;    // target packages not yet satisfied
+    QStringList remove;     // old packages the target profile does not need
+    QStringList keep;       // old packages shared with or satisfying the target
+    QStringList replaced;   // old packages pacman drops for conflicting with a new one
+    QString error;          // non-empty if the switch cannot be done safely
+
+    bool isEmpty() const { return install.isEmpty() && remove.isEmpty(); }
 };
 
 class DriverProfileManager
@@ -58,13 +89,50 @@ public:
     /// Get all predefined driver profiles
     static QList<DriverProfile> getAllProfiles();
 
+    /// Get all predefined wireless and ethernet driver profiles
+    static QList<DriverProfile> getNetworkProfiles();
+
+    /// Supported kernel range of a driver package, if it has a known one.
+    /// Checked by PackageManager before installing, on top of the version
+    /// constraints in the package's own depends.
+    static std::optional<KernelCompatibility> kernelCompatibility(const QString &package);
+
     /// Match and return applicable profiles for a detected GPU, with
-    /// install status and active flag populated
+    /// install status, active flag and recommendation score populated
     static QList<DriverProfile> getProfilesForDevice(
         const GpuDevice &device,
         PackageManager &packageManager
     );
 
+    /// Match and return applicable profiles for a detected wireless or
+    /// ethernet controller. Most of these work with an in-kernel driver, so
+    /// an empty list means nothing needs installing.
+    static QList<DriverProfile> getProfilesForNetworkDevice(
+        const NetworkDevice &device,
+        PackageManager &packageManager
+    );
+
+    /// Match and return applicable profiles for a USB device (wireless
+    /// dongles); empty if its in-kernel driver is all there is
+    static QList<DriverProfile> getProfilesForUsbDevice(
+        const UsbDevice &device,
+        PackageManager &packageManager
+    );
+
+    /// Compute the minimal package delta from one profile to another.
+    /// The target's firmware packages are installed along with it but never
+    /// removed, since other devices may share them.
+    /// Requirements are matched through pacman provides, conflicts of the
+    /// new packages are resolved against the old ones, and packages listed in
+    /// protectedPackages (e.g. needed by a profile active on another GPU) are
+    /// never removed.
+    static ProfileSwitchPlan planSwitch(
+        const DriverProfile &from,
+        const DriverProfile &to,
+        PackageManager &packageManager,
+        const QStringList &protectedPackages = {}
+    );
+
 private:
     /// Build all Intel driver profiles
     static QList<DriverProfile> buildIntelProfiles();
@@ -75,16 +143,56 @@ private:
     /// Build all NVIDIA driver profiles
     static QList<DriverProfile> buildNvidiaProfiles();
 
+    /// Build all out-of-tree wireless and ethernet driver profiles
+    static QList<DriverProfile> buildNetworkProfiles();
+
     /// Determine install status of a profile
     static InstallStatus checkInstallStatus(
         const DriverProfile &profile,
         PackageManager &packageManager
     );
 
+    /// Score a profile for the installed kernels: its preference, minus the
+    /// cost of DKMS and AUR builds, minus a prohibitive penalty if it cannot
+    /// be installed or leaves an installed kernel without its module
+    static int scoreProfile(
+        const DriverProfile &profile,
+        const QStringList &installedKernels,
+        PackageManager &packageManager
+    );
+
+    /// Score all profiles and mark the cheapest correct one as recommended
+    static void rankProfiles(
+        QList<DriverProfile> &profiles,
+        const QStringList &installedKernels,
+        PackageManager &packageManager
+    );
+
+    /// A device already bound to an in-kernel driver that a profile merely
+    /// replaces works as it is: no profile is recommended over it
+    static void preferBoundInKernelDriver(
+        QList<DriverProfile> &profiles,
+        const QString &kernelDriver
+    );
+
     /// Check if this profile's driver is the currently active kernel driver
     static bool isDriverActive(
         const DriverProfile &profile,
-        const GpuDevice &device
+        const GpuDevice &device,
+        PackageManager &packageManager
+    );
+
+    /// Fill firmwarePackages from the firmware the profile's modules request
+    static void resolveFirmware(
+        DriverProfile &profile,
+        PackageManager &packageManager
+    );
+
+    /// Check if this network profile's module is the bound kernel driver
+    static bool isModuleActive(
+        const DriverProfile &profile,
+        const QString &kernelDriver,
+        PackageManager &packageManager
     );
 };
 
@@ -0,0 +1,134 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "fileownershipindex.h"
+#include "systemaccess.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+
+#include <cstring>
+
+FileOwnershipIndex::FileOwnershipIndex(const QString &localDbPath)
+    : m_localDbPath(localDbPath)
+{
+}
+
+QString FileOwnershipIndex::ownerOf(const QString &path)
+{
+    ensureCurrent();
+
+    const QByteArray key = normalizePath(path);
+    if (key.isEmpty())
+        return {};
+
+    auto it = m_owners.constFind(hashPath(key));
+    if (it == m_owners.constEnd())
+        return {};
+    return m_packages.at(it.value());
+}
+
+void FileOwnershipIndex::invalidate()
+{
+    m_owners.clear();
+    m_packages.clear();
+    m_built = false;
+}
+
+void FileOwnershipIndex::ensureCurrent()
+{
+    // Installing, upgrading or removing a package adds or removes an entry
+    // directory, which bumps the mtime of the local DB directory itself.
+    const QDateTime modified = SystemAccess::instance().lastModified(m_localDbPath);
+    if (m_built && modified == m_builtFor)
+        return;
+
+    invalidate();
+    build();
+    m_builtFor = modified;
+    m_built = true;
+}
+
+void FileOwnershipIndex::build()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    SystemAccess &system = SystemAccess::instance();
+    const QStringList entries = system.entryList(m_localDbPath);
+    m_packages.reserve(entries.size());
+
+    for (const QString &entry : entries) {
+        // Entry directories are named "<pkgname>-<pkgver>-<pkgrel>"; neither
+        // pkgver nor pkgrel may contain '-', so the name is everything before
+        // the second-to-last dash.
+        const qsizetype relDash = entry.lastIndexOf('-');
+        const qsizetype verDash = relDash > 0 ? entry.lastIndexOf('-', relDash - 1) : -1;
+        if (verDash <= 0)
+            continue;
+
+        const std::optional<QByteArray> files = system.readFile(m_localDbPath + "/" + entry + "/files");
+        if (!files)
+            continue;
+
+        m_packages.append(entry.left(verDash));
+        indexFileList(*files, int(m_packages.size() - 1));
+    }
+
+    qDebug() << "File ownership index:" << m_owners.size() << "files from"
+             << m_packages.size() << "packages in" << timer.elapsed() << "ms";
+}
+
+void FileOwnershipIndex::indexFileList(const QByteArray &content, int packageIndex)
+{
+    const char *data = content.constData();
+    const qsizetype size = content.size();
+    qsizetype pos = 0;
+    bool inFiles = false;
+
+    while (pos < size) {
+        const char *newline = static_cast<const char *>(std::memchr(data + pos, '\n', size_t(size - pos)));
+        const qsizetype end = newline ? newline - data : size;
+        const QByteArrayView line(data + pos, end - pos);
+        pos = end + 1;
+
+        if (line.startsWith('%')) {
+            inFiles = (line == QByteArrayView("%FILES%"));
+            continue;
+        }
+
+        // Directories are shared between packages and never identify an owner
+        if (!inFiles || line.isEmpty() || line.endsWith('/'))
+            continue;
+
+        m_owners.insert(hashPath(line), packageIndex);
+    }
+}
+
+QByteArray FileOwnershipIndex::normalizePath(const QString &path)
+{
+    // Resolve symlinks such as /lib -> /usr/lib so the path matches the
+    // form recorded by pacman.
+    QString resolved = SystemAccess::instance().canonicalPath(path);
+    if (resolved.isEmpty())
+        resolved = QDir::cleanPath(path);
+
+    QByteArray key = resolved.toUtf8();
+    while (key.startsWith('/'))
+        key.remove(0, 1);
+    return key;
+}
+
+size_t FileOwnershipIndex::hashPath(QByteArrayView path)
+{
+    // Fixed seed: hashes must be stable for the lifetime of the index
+    return qHash(path, size_t(0));
+}
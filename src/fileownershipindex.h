@@ -0,0 +1,66 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef FILEOWNERSHIPINDEX_H
+#define FILEOWNERSHIPINDEX_H
+
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/// In-process equivalent of `pacman -Qo`, built from the file lists in the
+/// local package database (/var/lib/pacman/local/*/files).
+///
+/// Paths are stored as 64-bit hashes mapped to an index into the package
+/// name table, which keeps the whole-system index to a few MB. The index is
+/// built lazily on the first lookup and reused until the local database
+/// directory changes.
+///
+/// The database is read through SystemAccess, so recorded scans replay with
+/// the recorded package set.
+class FileOwnershipIndex
+{
+public:
+    explicit FileOwnershipIndex(const QString &localDbPath = QStringLiteral("/var/lib/pacman/local"));
+
+    /// Return the package owning an absolute file path, or empty string
+    QString ownerOf(const QString &path);
+
+    /// Drop the cached index; it is rebuilt on the next lookup
+    void invalidate();
+
+    /// Number of files currently indexed
+    qsizetype size() const { return m_owners.size(); }
+
+private:
+    /// Rebuild the index if it was never built or the local DB changed
+    void ensureCurrent();
+
+    /// Read every package's file list into the index
+    void build();
+
+    /// Add the %FILES% section of one package's `files` entry
+    void indexFileList(const QByteArray &content, int packageIndex);
+
+    /// Turn an absolute path into the form stored in the DB ("usr/lib/...")
+    static QByteArray normalizePath(const QString &path);
+
+    static size_t hashPath(QByteArrayView path);
+
+    QString m_localDbPath;
+    QHash<size_t, int> m_owners;   // path hash -> index into m_packages
+    QStringList m_packages;        // package names
+    QDateTime m_builtFor;          // local DB mtime the index reflects
+    bool m_built = false;
+};
+
+#endif // FILEOWNERSHIPINDEX_H
@@ -9,9 +9,220 @@
  */
 
 #include "hardwaredetector.h"
+#include "systemaccess.h"
+#include "usbidsdatabase.h"
 
-#include <QProcess>
-#include <QRegularExpression>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// lspci tokenizer helpers
+//
+// These operate on views into the raw `lspci -nn -k` output so that lines
+// belonging to devices of no interest are classified and skipped without
+// allocating.
+// ---------------------------------------------------------------------------
+namespace {
+
+/// Parse exactly four hex digits, returns -1 if any character is not hex
+int parseHex4(const char *p)
+{
+    int value = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = p[i];
+        int digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return -1;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+bool startsWithNoCase(QByteArrayView view, const char *prefix)
+{
+    const qsizetype len = qsizetype(std::strlen(prefix));
+    return view.size() >= len && qstrnicmp(view.data(), prefix, size_t(len)) == 0;
+}
+
+/// Description split into the bare device name and its trailing PCI ID
+struct DescriptionFields {
+    QByteArrayView name;      // e.g. "NVIDIA Corporation AD107M [GeForce RTX 4060]"
+    QByteArrayView vendorId;  // e.g. "10de"
+    QByteArrayView deviceId;  // e.g. "28e0"
+};
+
+/// Strip the trailing "(rev xx)" and "[vvvv:dddd]" tokens from a description
+DescriptionFields splitDescription(QByteArrayView desc)
+{
+    DescriptionFields fields;
+    desc = desc.trimmed();
+
+    // "(rev a1)"
+    if (desc.endsWith(')')) {
+        const qsizetype revPos = desc.lastIndexOf(QByteArrayView("(rev "));
+        if (revPos >= 0)
+            desc = desc.first(revPos).trimmed();
+    }
+
+    // "[10de:28e0]"
+    if (desc.size() >= 11 && desc.endsWith(']')) {
+        const char *id = desc.data() + desc.size() - 11;
+        if (id[0] == '[' && id[5] == ':' && parseHex4(id + 1) >= 0 && parseHex4(id + 6) >= 0) {
+            fields.vendorId = QByteArrayView(id + 1, 4);
+            fields.deviceId = QByteArrayView(id + 6, 4);
+            desc = desc.first(desc.size() - 11).trimmed();
+        }
+    }
+
+    fields.name = desc;
+    return fields;
+}
+
+/// Map a PCI vendor ID to the vendor string, empty if unknown
+QString vendorFromId(QByteArrayView vendorId)
+{
+    switch (vendorId.isEmpty() ? -1 : parseHex4(vendorId.data())) {
+    case 0x10de:
+        return QStringLiteral("NVIDIA");
+    case 0x1002:
+    case 0x1022:
+        return QStringLiteral("AMD");
+    case 0x8086:
+        return QStringLiteral("Intel");
+    default:
+        return {};
+    }
+}
+
+/// Kinds of device the detector reports
+enum class DeviceKind {
+    Gpu,
+    Wireless,
+    Ethernet
+};
+
+/// PCI class dispatch: (class code & mask) == code selects the kind.
+/// Adding a class here is all it takes to have it picked up by the scan.
+struct ClassHandler {
+    quint16 code;
+    quint16 mask;
+    DeviceKind kind;
+};
+
+constexpr ClassHandler kClassTable[] = {
+    {0x0300, 0xff00, DeviceKind::Gpu},      // display controllers: VGA, XGA, 3D, other
+    {0x0280, 0xffff, DeviceKind::Wireless}, // network controller (Wi-Fi)
+    {0x0200, 0xffff, DeviceKind::Ethernet}, // ethernet controller
+};
+
+const ClassHandler *classHandler(int classCode)
+{
+    for (const ClassHandler &handler : kClassTable) {
+        if ((classCode & handler.mask) == handler.code)
+            return &handler;
+    }
+    return nullptr;
+}
+
+/// Network chip vendors by PCI vendor ID, with the lspci name prefix to
+/// strip from the model
+struct NetworkVendor {
+    int id;
+    const char *name;
+    const char *prefix;
+};
+
+constexpr NetworkVendor kNetworkVendors[] = {
+    {0x14e4, "Broadcom", "Broadcom Inc. and subsidiaries"},
+    {0x10ec, "Realtek", "Realtek Semiconductor Co., Ltd."},
+    {0x8086, "Intel", "Intel Corporation"},
+    {0x168c, "Qualcomm Atheros", "Qualcomm Atheros"},
+    {0x17cb, "Qualcomm", "Qualcomm Technologies, Inc"},
+    {0x14c3, "MediaTek", "MEDIATEK Corp."},
+    {0x1814, "Ralink", "Ralink corp."},
+};
+
+/// Fill vendor and model of a network device from its description
+void describeNetworkDevice(NetworkDevice &device, QByteArrayView vendorId, QByteArrayView name)
+{
+    const int id = vendorId.isEmpty() ? -1 : parseHex4(vendorId.data());
+    for (const NetworkVendor &vendor : kNetworkVendors) {
+        if (vendor.id != id)
+            continue;
+        device.vendor = QString::fromLatin1(vendor.name);
+        if (startsWithNoCase(name, vendor.prefix))
+            name = name.sliced(qsizetype(std::strlen(vendor.prefix)));
+        device.model = QString::fromUtf8(name.trimmed());
+        return;
+    }
+    device.vendor = QStringLiteral("Unknown");
+    device.model = QString::fromUtf8(name.trimmed());
+}
+
+/// Derive the marketing model name from a device name without its PCI ID
+QString modelFromName(QByteArrayView name, const QString &vendor)
+{
+    if (vendor == QLatin1String("NVIDIA")) {
+        // Prefer the bracketed marketing name: "AD107M [GeForce RTX 4060]"
+        if (name.endsWith(']')) {
+            const qsizetype open = name.lastIndexOf('[');
+            if (open >= 0)
+                return QString::fromUtf8(name.sliced(open + 1, name.size() - open - 2).trimmed());
+        }
+        if (startsWithNoCase(name, "NVIDIA Corporation"))
+            name = name.sliced(18);
+        return QString::fromUtf8(name.trimmed());
+    }
+
+    if (vendor == QLatin1String("AMD")) {
+        // "Advanced Micro Devices, Inc. [AMD/ATI] Navi 33 ..."
+        if (name.startsWith("Advanced Micro Devices")) {
+            QByteArrayView rest = name.sliced(22);
+            if (rest.startsWith(','))
+                rest = rest.sliced(1);
+            rest = rest.trimmed();
+            if (rest.startsWith("Inc"))
+                rest = rest.sliced(3);
+            if (rest.startsWith('.'))
+                rest = rest.sliced(1);
+            rest = rest.trimmed();
+            if (rest.startsWith("[AMD/ATI]"))
+                name = rest.sliced(9);
+            else if (rest.startsWith("[AMD]"))
+                name = rest.sliced(5);
+        }
+        return QString::fromUtf8(name.trimmed());
+    }
+
+    if (vendor == QLatin1String("Intel")) {
+        if (startsWithNoCase(name, "Intel Corporation"))
+            name = name.sliced(17);
+        return QString::fromUtf8(name.trimmed());
+    }
+
+    return QString::fromUtf8(name);
+}
+
+/// Append the comma-separated module list of a "Kernel modules:" attribute
+void appendModules(QByteArrayView list, QStringList &modules)
+{
+    while (!list.isEmpty()) {
+        qsizetype comma = list.indexOf(',');
+        if (comma < 0)
+            comma = list.size();
+        const QByteArrayView module = list.first(comma).trimmed();
+        if (!module.isEmpty())
+            modules.append(QString::fromUtf8(module));
+        list = comma < list.size() ? list.sliced(comma + 1) : QByteArrayView();
+    }
+}
+
+} // namespace
 
 HardwareDetector::HardwareDetector(QObject *parent)
     : QObject(parent)
@@ -22,12 +233,22 @@ HardwareDetector::~HardwareDetector()
 {
 }
 
-QList<GpuDevice> HardwareDetector::detectGpus()
+DetectedDevices HardwareDetector::detectDevices()
 {
-    QString output = runCommand("lspci", {"-nn", "-k"});
+    const QByteArray output = runCommand("lspci", {"-nn", "-k"});
     return parseLspciOutput(output);
 }
 
+QList<GpuDevice> HardwareDetector::detectGpus()
+{
+    return detectDevices().gpus;
+}
+
+QList<NetworkDevice> HardwareDetector::detectNetworkDevices()
+{
+    return detectDevices().network;
+}
+
 QString HardwareDetector::identifyVendor(const QString &rawVendor)
 {
     QString lower = rawVendor.toLower();
@@ -42,42 +263,9 @@ QString HardwareDetector::identifyVendor(const QString &rawVendor)
 
 QString HardwareDetector::extractModel(const QString &rawDescription, const QString &vendor)
 {
-    QString desc = rawDescription;
-
-    static QRegularExpression pciIdRe(R"(\s*\[\w{4}:\w{4}\])");
-    desc.remove(pciIdRe);
-
-    static QRegularExpression revRe(R"(\s*\(rev \w+\))");
-    desc.remove(revRe);
-
-    static QRegularExpression classRe(R"(\s*\[\w{4}\])");
-    desc.remove(classRe);
-
-    desc = desc.trimmed();
-
-    if (vendor == "NVIDIA") {
-        static QRegularExpression bracketModel(R"(\[([^\]]+)\]\s*$)");
-        auto match = bracketModel.match(desc);
-        if (match.hasMatch())
-            return match.captured(1).trimmed();
-        desc.remove("NVIDIA Corporation", Qt::CaseInsensitive);
-        return desc.trimmed();
-    }
-
-    if (vendor == "AMD") {
-        static QRegularExpression amdPrefix(R"(^Advanced Micro Devices,?\s*Inc\.?\s*\[AMD/?ATI?\]\s*)");
-        desc.remove(amdPrefix);
-        return desc.trimmed();
-    }
-
-    if (vendor == "Intel") {
-        desc.remove("Intel Corporation", Qt::CaseInsensitive);
-        return desc.trimmed();
-    }
-
-    return desc;
+    const QByteArray desc = rawDescription.toUtf8();
+    return modelFromName(splitDescription(desc).name, vendor);
 }
-
 // ---------------------------------------------------------------------------
 // Architecture detection
 // ---------------------------------------------------------------------------
@@ -227,76 +415,290 @@ QString HardwareDetector::archToString(GpuArch arch)
 }
 
 // ---------------------------------------------------------------------------
-// Command execution & lspci parsing
+// Installed kernels
+// ---------------------------------------------------------------------------
+
+QStringList HardwareDetector::installedKernels()
+{
+    SystemAccess &system = SystemAccess::instance();
+
+    QStringList kernels;
+    const QStringList versions = system.entryList("/usr/lib/modules");
+    for (const QString &version : versions) {
+        const std::optional<QByteArray> content =
+            system.readFile("/usr/lib/modules/" + version + "/pkgbase");
+        if (!content)
+            continue;
+        const QString pkgbase = QString::fromUtf8(*content).trimmed();
+        if (!pkgbase.isEmpty() && !kernels.contains(pkgbase))
+            kernels.append(pkgbase);
+    }
+    kernels.sort();
+    return kernels;
+}
+
 // ---------------------------------------------------------------------------
+// USB devices
+// ---------------------------------------------------------------------------
+
+namespace {
+
+const QString kUsbDevicesDir = QStringLiteral("/sys/bus/usb/devices");
 
-QString HardwareDetector::runCommand(const QString &command, const QStringList &args) const
+/// Device directories are "<bus>-<port>[.<port>...]"; root hubs are "usbN"
+/// and interfaces "<device>:<config>.<interface>"
+bool isUsbDeviceName(const QString &name)
 {
-    QProcess process;
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start(command, args);
-    process.waitForFinished(5000);
-    return process.readAllStandardOutput();
+    return !name.isEmpty() && name.at(0).isDigit() && !name.contains(':');
 }
 
-QList<GpuDevice> HardwareDetector::parseLspciOutput(const QString &output)
+QString readSysfsAttribute(const QString &path)
 {
-    QList<GpuDevice> gpus;
+    const std::optional<QByteArray> content = SystemAccess::instance().readFile(path);
+    return content ? QString::fromLatin1(content->trimmed()) : QString();
+}
 
-    static QRegularExpression gpuHeaderRe(
-        R"(^(\S+)\s+((?:VGA compatible|3D|Display)\s+controller)\s+\[(\w{4})\]:\s+(.+)$)",
-        QRegularExpression::CaseInsensitiveOption
-    );
+/// DRIVER= from an interface's uevent; empty while unbound
+QString interfaceDriver(const QString &interfaceName)
+{
+    const std::optional<QByteArray> uevent =
+        SystemAccess::instance().readFile(kUsbDevicesDir + "/" + interfaceName + "/uevent");
+    if (!uevent)
+        return {};
+    for (const QByteArray &line : uevent->split('\n')) {
+        if (line.startsWith("DRIVER="))
+            return QString::fromLatin1(line.sliced(7).trimmed());
+    }
+    return {};
+}
 
-    static QRegularExpression pciIdRe(R"(\[(\w{4}):(\w{4})\])");
+} // namespace
 
-    QStringList lines = output.split('\n');
+QList<UsbDevice> HardwareDetector::detectUsbDevices()
+{
+    // One directory listing gives both devices and their interfaces
+    const QStringList entries = SystemAccess::instance().entryList(kUsbDevicesDir);
 
-    for (int i = 0; i < lines.size(); ++i) {
-        const QString &line = lines[i];
-        auto headerMatch = gpuHeaderRe.match(line);
-        if (!headerMatch.hasMatch())
+    QList<UsbDevice> devices;
+    for (const QString &name : entries) {
+        if (!isUsbDeviceName(name))
             continue;
 
-        GpuDevice gpu;
-        gpu.pciSlot = headerMatch.captured(1);
-        gpu.deviceClass = headerMatch.captured(2);
-        QString fullDesc = headerMatch.captured(4);
-
-        auto pciIdMatch = pciIdRe.match(fullDesc);
-        if (pciIdMatch.hasMatch()) {
-            gpu.vendorId = pciIdMatch.captured(1);
-            gpu.deviceId = pciIdMatch.captured(2);
-            gpu.pciId = gpu.vendorId + ":" + gpu.deviceId;
+        const QString prefix = name + ':';
+        QStringList interfaces;
+        for (const QString &entry : entries) {
+            if (entry.startsWith(prefix))
+                interfaces.append(entry);
         }
 
-        gpu.vendor = identifyVendor(fullDesc);
-        gpu.model = extractModel(fullDesc, gpu.vendor);
-
-        for (int j = i + 1; j < lines.size(); ++j) {
-            const QString &subLine = lines[j];
-            if (!subLine.startsWith('\t') && !subLine.startsWith("  "))
-                break;
-
-            QString trimmed = subLine.trimmed();
-
-            if (trimmed.startsWith("Subsystem:")) {
-                gpu.subsystem = trimmed.mid(10).trimmed();
-            } else if (trimmed.startsWith("Kernel driver in use:")) {
-                gpu.kernelDriver = trimmed.mid(21).trimmed();
-            } else if (trimmed.startsWith("Kernel modules:")) {
-                QString modulesStr = trimmed.mid(15).trimmed();
-                gpu.kernelModules = modulesStr.split(',', Qt::SkipEmptyParts);
-                for (auto &m : gpu.kernelModules)
-                    m = m.trimmed();
+        if (std::optional<UsbDevice> device = readUsbDevice(name, interfaces))
+            devices.append(*device);
+    }
+    return devices;
+}
+
+std::optional<UsbDevice> HardwareDetector::detectUsbDevice(const QString &sysfsName)
+{
+    if (!isUsbDeviceName(sysfsName))
+        return std::nullopt;
+
+    // Interfaces also appear as subdirectories of the device itself
+    QStringList interfaces;
+    const QString prefix = sysfsName + ':';
+    for (const QString &entry : SystemAccess::instance().entryList(kUsbDevicesDir + "/" + sysfsName)) {
+        if (entry.startsWith(prefix))
+            interfaces.append(entry);
+    }
+    return readUsbDevice(sysfsName, interfaces);
+}
+
+std::optional<UsbDevice> HardwareDetector::readUsbDevice(const QString &sysfsName, const QStringList &interfaces)
+{
+    const QString dir = kUsbDevicesDir + "/" + sysfsName + "/";
+
+    UsbDevice device;
+    device.sysfsName = sysfsName;
+    device.vendorId = readSysfsAttribute(dir + "idVendor");
+    device.productId = readSysfsAttribute(dir + "idProduct");
+    if (device.vendorId.isEmpty() || device.productId.isEmpty())
+        return std::nullopt;
+
+    // Hubs have no driver profiles
+    if (readSysfsAttribute(dir + "bDeviceClass") == "09")
+        return std::nullopt;
+
+    device.usbId = device.vendorId + ":" + device.productId;
+
+    UsbIdsDatabase &ids = UsbIdsDatabase::instance();
+    device.vendor = ids.vendorName(device.vendorId);
+    device.product = ids.productName(device.vendorId, device.productId);
+    // Fall back to the strings the device reports about itself
+    if (device.vendor.isEmpty())
+        device.vendor = readSysfsAttribute(dir + "manufacturer");
+    if (device.product.isEmpty())
+        device.product = readSysfsAttribute(dir + "product");
+
+    for (const QString &iface : interfaces) {
+        device.kernelDriver = interfaceDriver(iface);
+        if (!device.kernelDriver.isEmpty())
+            break;
+    }
+    return device;
+}
+
+// ---------------------------------------------------------------------------
+// Runtime power management
+// ---------------------------------------------------------------------------
+
+bool HardwareDetector::supportsRuntimeD3(const GpuDevice &device)
+{
+    // Fine-grained runtime D3 needs Turing or newer, and is only used for
+    // GPUs that do not drive a display themselves (class 0x0302)
+    if (device.vendor != "NVIDIA" || device.classCode != 0x0302)
+        return false;
+
+    switch (device.architecture) {
+    case GpuArch::NvidiaTuring:
+    case GpuArch::NvidiaAmpere:
+    case GpuArch::NvidiaAdaLovelace:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool HardwareDetector::supportsNvidiaPowerd(const GpuDevice &device)
+{
+    return supportsRuntimeD3(device) && device.architecture != GpuArch::NvidiaTuring;
+}
+
+QString HardwareDetector::runtimePowerStatus(const QString &pciSlot)
+{
+    // lspci omits the PCI domain when there is only one
+    const QString address = pciSlot.count(':') == 1 ? "0000:" + pciSlot : pciSlot;
+
+    const std::optional<QByteArray> status =
+        SystemAccess::instance().readFile("/sys/bus/pci/devices/" + address + "/power/runtime_status");
+    if (!status)
+        return {};
+    return QString::fromLatin1(*status).trimmed();
+}
+
+// ---------------------------------------------------------------------------
+// Command execution & lspci parsing
+// ---------------------------------------------------------------------------
+
+QByteArray HardwareDetector::runCommand(const QString &command, const QStringList &args) const
+{
+    return SystemAccess::instance().run(command, args, 5000).output;
+}
+
+DetectedDevices HardwareDetector::parseLspciOutput(const QByteArray &output)
+{
+    // Single forward pass over the raw output. Each device starts with an
+    // unindented header line:
+    //   01:00.0 VGA compatible controller [0300]: NVIDIA Corporation ... [10de:28e0] (rev a1)
+    // followed by indented attribute lines. Headers are dispatched on their
+    // PCI class code through kClassTable, so only devices of a known class
+    // ever allocate; attribute lines of other devices are skipped as views.
+    DetectedDevices devices;
+
+    // Attribute fields of the device currently being parsed, if any
+    struct {
+        QString *subsystem = nullptr;
+        QString *kernelDriver = nullptr;
+        QStringList *kernelModules = nullptr;
+    } current;
+
+    const char *data = output.constData();
+    const qsizetype size = output.size();
+    qsizetype pos = 0;
+
+    while (pos < size) {
+        const char *newline = static_cast<const char *>(std::memchr(data + pos, '\n', size_t(size - pos)));
+        const qsizetype end = newline ? newline - data : size;
+        const QByteArrayView line(data + pos, end - pos);
+        pos = end + 1;
+
+        if (line.isEmpty()) {
+            current = {};
+            continue;
+        }
+
+        // Attribute line of the current device
+        if (line.front() == '\t' || line.front() == ' ') {
+            if (!current.subsystem)
+                continue;
+
+            const QByteArrayView attr = line.trimmed();
+            if (attr.startsWith("Subsystem:")) {
+                *current.subsystem = QString::fromUtf8(attr.sliced(10).trimmed());
+            } else if (attr.startsWith("Kernel driver in use:")) {
+                *current.kernelDriver = QString::fromUtf8(attr.sliced(21).trimmed());
+            } else if (attr.startsWith("Kernel modules:")) {
+                appendModules(attr.sliced(15), *current.kernelModules);
             }
+            continue;
+        }
+
+        // Header line: "<slot> <class name> [cccc]: <description>"
+        current = {};
+
+        const qsizetype slotEnd = line.indexOf(' ');
+        const qsizetype classEnd = line.indexOf(QByteArrayView("]: "));
+        if (slotEnd <= 0 || classEnd < slotEnd + 6 || line.at(classEnd - 5) != '[')
+            continue;
+
+        const int classCode = parseHex4(line.data() + classEnd - 4);
+        const ClassHandler *handler = classCode >= 0 ? classHandler(classCode) : nullptr;
+        if (!handler)
+            continue;
+
+        const DescriptionFields fields = splitDescription(line.sliced(classEnd + 3));
+
+        if (handler->kind != DeviceKind::Gpu) {
+            NetworkDevice net;
+            net.pciSlot = QString::fromLatin1(line.first(slotEnd));
+            net.classCode = quint16(classCode);
+            net.wireless = handler->kind == DeviceKind::Wireless;
+            if (!fields.vendorId.isEmpty()) {
+                net.vendorId = QString::fromLatin1(fields.vendorId);
+                net.deviceId = QString::fromLatin1(fields.deviceId);
+                net.pciId = net.vendorId + ":" + net.deviceId;
+            }
+            describeNetworkDevice(net, fields.vendorId, fields.name);
+
+            devices.network.append(net);
+            NetworkDevice &added = devices.network.last();
+            current.subsystem = &added.subsystem;
+            current.kernelDriver = &added.kernelDriver;
+            current.kernelModules = &added.kernelModules;
+            continue;
+        }
+
+        GpuDevice gpu;
+        gpu.pciSlot = QString::fromLatin1(line.first(slotEnd));
+        gpu.deviceClass = QString::fromUtf8(
+            line.sliced(slotEnd + 1, classEnd - 5 - slotEnd - 1).trimmed());
+        gpu.classCode = quint16(classCode);
+        if (!fields.vendorId.isEmpty()) {
+            gpu.vendorId = QString::fromLatin1(fields.vendorId);
+            gpu.deviceId = QString::fromLatin1(fields.deviceId);
+            gpu.pciId = gpu.vendorId + ":" + gpu.deviceId;
         }
 
-        // Detect architecture after all device info is gathered
+        gpu.vendor = vendorFromId(fields.vendorId);
+        if (gpu.vendor.isEmpty())
+            gpu.vendor = identifyVendor(QString::fromUtf8(fields.name));
+        gpu.model = modelFromName(fields.name, gpu.vendor);
         gpu.architecture = detectArchitecture(gpu.vendor, gpu.deviceId, gpu.model);
 
-        gpus.append(gpu);
+        devices.gpus.append(gpu);
+        GpuDevice &added = devices.gpus.last();
+        current.subsystem = &added.subsystem;
+        current.kernelDriver = &added.kernelDriver;
+        current.kernelModules = &added.kernelModules;
     }
 
-    return gpus;
+    return devices;
 }
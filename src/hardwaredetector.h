@@ -12,10 +12,13 @@
 #define HARDWAREDETECTOR_H
 
 #include <QObject>
+#include <QByteArray>
 #include <QString>
 #include <QList>
 #include <QStringList>
 
+#include <optional>
+
 /// GPU architecture generation for filtering driver profiles
 enum class GpuArch {
     Unknown,
@@ -48,9 +51,40 @@ struct GpuDevice {
     QStringList kernelModules; // available kernel modules
     QString subsystem;     // e.g. "Lenovo Device"
     QString deviceClass;   // e.g. "VGA compatible controller", "3D controller"
+    quint16 classCode = 0; // PCI class/subclass, e.g. 0x0300 (VGA), 0x0302 (3D)
     GpuArch architecture;  // detected GPU architecture generation
 };
 
+struct NetworkDevice {
+    QString pciSlot;       // e.g. "03:00.0"
+    QString vendor;        // e.g. "Broadcom", "Realtek", "Intel"
+    QString model;         // e.g. "BCM4360 802.11ac Wireless Network Adapter"
+    QString pciId;         // vendor:device e.g. "14e4:43a0"
+    QString vendorId;      // e.g. "14e4"
+    QString deviceId;      // e.g. "43a0"
+    QString kernelDriver;  // e.g. "wl", "r8169", "iwlwifi"
+    QStringList kernelModules; // available kernel modules
+    QString subsystem;     // e.g. "Apple Inc. BCM4360 802.11ac Wireless Network Adapter"
+    quint16 classCode = 0; // 0x0280 (wireless) or 0x0200 (ethernet)
+    bool wireless = false; // network controller class 0x0280
+};
+
+struct UsbDevice {
+    QString sysfsName;     // e.g. "1-2" (/sys/bus/usb/devices/1-2)
+    QString vendor;        // from usb.ids, e.g. "Realtek Semiconductor Corp."
+    QString product;       // from usb.ids, e.g. "RTL88x2bu [AC1200 Techkey]"
+    QString usbId;         // vendor:product e.g. "0bda:b812"
+    QString vendorId;      // e.g. "0bda"
+    QString productId;     // e.g. "b812"
+    QString kernelDriver;  // driver bound to the first claimed interface, e.g. "rtw88_8822bu"
+};
+
+/// Everything driver-relevant found in one enumeration pass
+struct DetectedDevices {
+    QList<GpuDevice> gpus;
+    QList<NetworkDevice> network;
+};
+
 class HardwareDetector : public QObject
 {
     Q_OBJECT
@@ -59,9 +93,22 @@ public:
     explicit HardwareDetector(QObject *parent = nullptr);
     ~HardwareDetector();
 
+    /// Run lspci once and classify every driver-relevant device
+    DetectedDevices detectDevices();
+
     /// Run lspci and detect all GPU devices
     QList<GpuDevice> detectGpus();
 
+    /// Run lspci and detect wireless and ethernet controllers
+    QList<NetworkDevice> detectNetworkDevices();
+
+    /// Enumerate USB devices from /sys/bus/usb/devices, skipping hubs
+    QList<UsbDevice> detectUsbDevices();
+
+    /// Read a single USB device by its sysfs name (e.g. "1-2"), for
+    /// incremental updates on hot-plug; nullopt if gone or a hub
+    std::optional<UsbDevice> detectUsbDevice(const QString &sysfsName);
+
     /// Identify the vendor string from a raw lspci vendor description
     static QString identifyVendor(const QString &rawVendor);
 
@@ -74,12 +121,31 @@ public:
     /// Get a human-readable name for a GPU architecture
     static QString archToString(GpuArch arch);
 
+    /// Package names of the installed kernels (e.g. "linux", "linux-lts"),
+    /// from /usr/lib/modules/*/pkgbase
+    static QStringList installedKernels();
+
+    /// Whether the proprietary driver can put this GPU into runtime D3:
+    /// a Turing-or-newer NVIDIA render-only "3D controller" (hybrid laptop dGPU)
+    static bool supportsRuntimeD3(const GpuDevice &device);
+
+    /// Whether nvidia-powerd (Dynamic Boost) applies: Ampere-or-newer laptop dGPU
+    static bool supportsNvidiaPowerd(const GpuDevice &device);
+
+    /// Runtime PM state from /sys/bus/pci/devices/<slot>/power/runtime_status,
+    /// e.g. "active", "suspended", "unsupported"; empty if not readable
+    static QString runtimePowerStatus(const QString &pciSlot);
+
 private:
-    /// Run a command and return its stdout
-    QString runCommand(const QString &command, const QStringList &args) const;
+    /// Run a command and return its raw stdout
+    QByteArray runCommand(const QString &command, const QStringList &args) const;
+
+    /// Parse the full output of `lspci -nn -k`, dispatching each device on
+    /// its PCI class code
+    DetectedDevices parseLspciOutput(const QByteArray &output);
 
-    /// Parse the full output of `lspci -nn -k` to find GPU entries
-    QList<GpuDevice> parseLspciOutput(const QString &output);
+    /// Read one USB device given the names of its interface directories
+    static std::optional<UsbDevice> readUsbDevice(const QString &sysfsName, const QStringList &interfaces);
 
     // Architecture detection helpers
     static GpuArch detectNvidiaArch(const QString &deviceId, const QString &model);
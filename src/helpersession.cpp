@@ -0,0 +1,170 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "helpersession.h"
+
+#include <QDebug>
+
+namespace {
+
+/// Protocol version the helper must greet with
+constexpr int kProtocolVersion = 1;
+
+/// Commands the helper runs inside a session; SESSION_COMMANDS in
+/// rscn-drivers-pkhelper must list the same ones
+const char *const kSessionCommands[] = {
+    "install", "install-deps", "install-local", "remove", "switch", "dkms-build",
+    "remove-kms-hook", "regenerate-initramfs", "regenerate-grub", "kernel-params",
+    "early-kms", "runtime-pm",
+};
+
+} // namespace
+
+HelperSession::HelperSession(const QString &helperPath, QObject *parent)
+    : QObject(parent)
+    , m_helperPath(helperPath)
+{
+}
+
+HelperSession::~HelperSession()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        m_process->closeWriteChannel();
+        if (!m_process->waitForFinished(3000))
+            m_process->kill();
+    }
+}
+
+void HelperSession::open()
+{
+    if (m_process)
+        return;
+
+    m_process = new QProcess(this);
+    // stderr carries the helper's own errors; keep it out of the frames
+    m_process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    connect(m_process, &QProcess::readyReadStandardOutput,
+            this, &HelperSession::onReadyRead);
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &HelperSession::onProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            onProcessFinished(-1, QProcess::CrashExit);
+    });
+
+    qDebug() << "Opening privileged session: pkexec" << m_helperPath << "session";
+    m_process->start("pkexec", {m_helperPath, "session"});
+}
+
+void HelperSession::close()
+{
+    if (m_process)
+        m_process->closeWriteChannel();
+}
+
+bool HelperSession::acceptsCommand(const QString &command)
+{
+    for (const char *allowed : kSessionCommands) {
+        if (command == QLatin1String(allowed))
+            return true;
+    }
+    return false;
+}
+
+int HelperSession::submit(const QStringList &helperArgs)
+{
+    if (!m_ready || helperArgs.isEmpty())
+        return -1;
+    for (const QString &arg : helperArgs) {
+        if (arg.contains('\n'))
+            return -1;
+    }
+
+    const int id = m_nextId++;
+    QByteArray frame = "RUN " + QByteArray::number(id) + ' ' + QByteArray::number(helperArgs.size()) + '\n';
+    for (const QString &arg : helperArgs)
+        frame += arg.toUtf8() + '\n';
+    m_process->write(frame);
+    return id;
+}
+
+void HelperSession::onReadyRead()
+{
+    m_buffer += m_process->readAllStandardOutput();
+
+    qsizetype start = 0;
+    for (;;) {
+        const qsizetype newline = m_buffer.indexOf('\n', start);
+        if (newline < 0)
+            break;
+        handleFrame(m_buffer.sliced(start, newline - start));
+        start = newline + 1;
+    }
+    m_buffer.remove(0, start);
+}
+
+void HelperSession::handleFrame(const QByteArray &frame)
+{
+    // READY <protocol> | OUT <id> <line> | END <id> <exit code>
+    const qsizetype firstSpace = frame.indexOf(' ');
+    const QByteArray kind = frame.first(firstSpace < 0 ? frame.size() : firstSpace);
+    const QByteArray rest = firstSpace < 0 ? QByteArray() : frame.sliced(firstSpace + 1);
+
+    if (kind == "READY") {
+        if (rest.toInt() != kProtocolVersion) {
+            qWarning() << "Privileged helper speaks session protocol" << rest << "- expected" << kProtocolVersion;
+            close();
+            return;
+        }
+        m_ready = true;
+        emit opened();
+        return;
+    }
+
+    const qsizetype idEnd = rest.indexOf(' ');
+    bool ok = false;
+    const int id = rest.first(idEnd < 0 ? rest.size() : idEnd).toInt(&ok);
+    if (!ok) {
+        qWarning() << "Malformed frame from privileged helper:" << frame;
+        return;
+    }
+    const QByteArray payload = idEnd < 0 ? QByteArray() : rest.sliced(idEnd + 1);
+
+    if (kind == "OUT")
+        emit output(id, payload);
+    else if (kind == "END")
+        emit finished(id, payload.toInt());
+}
+
+void HelperSession::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    const bool wasReady = m_ready;
+    m_ready = false;
+    m_buffer.clear();
+    if (m_process) {
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
+
+    if (wasReady) {
+        emit closed();
+        return;
+    }
+
+    // Ended before the greeting: pkexec refused or the helper is missing
+    if (exitStatus == QProcess::NormalExit && exitCode == 126)
+        emit openFailed(tr("Authorization was dismissed by the user"));
+    else if (exitStatus == QProcess::NormalExit && exitCode == 127)
+        emit openFailed(tr("Authorization failed or helper not found"));
+    else
+        emit openFailed(tr("The privileged session could not be started"));
+}
@@ -0,0 +1,80 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef HELPERSESSION_H
+#define HELPERSESSION_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+/// Client for the privileged helper's session mode
+/// (`pkexec rscn-drivers-pkhelper session`).
+///
+/// One pkexec authorization starts a helper that keeps serving commands
+/// written to its stdin, so multi-step operations (install, early KMS,
+/// initramfs, bootloader) do not each pay for a new pkexec, bash start and
+/// polkit prompt. Each request gets its own output lines and exit code.
+/// Closing the session closes the helper's stdin, which ends it.
+class HelperSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HelperSession(const QString &helperPath, QObject *parent = nullptr);
+    ~HelperSession();
+
+    /// Start the helper through pkexec; emits opened() or openFailed()
+    void open();
+
+    /// Close the helper's stdin and let it exit
+    void close();
+
+    /// Ready to take requests (authorized and greeted)
+    bool isOpen() const { return m_ready; }
+
+    /// Send a command; returns its request id, or -1 if the session is not
+    /// open or an argument contains a newline
+    int submit(const QStringList &helperArgs);
+
+    /// Whether the helper runs this command inside a session; others (e.g.
+    /// rollback) need a one-shot pkexec invocation
+    static bool acceptsCommand(const QString &command);
+
+signals:
+    void opened();
+    void openFailed(const QString &error);
+
+    /// One line of output of a request
+    void output(int id, const QByteArray &line);
+
+    /// A request completed with the helper command's exit code
+    void finished(int id, int exitCode);
+
+    /// The helper exited (after close() or unexpectedly)
+    void closed();
+
+private slots:
+    void onReadyRead();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    /// Handle one protocol frame from the helper
+    void handleFrame(const QByteArray &frame);
+
+    QString m_helperPath;
+    QProcess *m_process = nullptr;
+    QByteArray m_buffer;
+    int m_nextId = 1;
+    bool m_ready = false;
+};
+
+#endif // HELPERSESSION_H
@@ -9,16 +9,124 @@
  */
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include <cstring>
+
 #include "mainwindow.h"
+#include "metricsexporter.h"
+#include "pacmanloganalyzer.h"
+#include "systemaccess.h"
+
+namespace {
+
+void setApplicationInfo()
+{
+    QCoreApplication::setApplicationName("RSCN Drivers");
+    QCoreApplication::setApplicationVersion("1.0.0");
+    QCoreApplication::setOrganizationName("RSCN");
+}
+
+/// Headless modes must be detected before any QApplication is created,
+/// so that they also work without a display server.
+bool isHeadlessInvocation(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--export-metrics", 16) == 0
+            || std::strcmp(argv[i], "--driver-history") == 0)
+            return true;
+    }
+    return false;
+}
+
+/// Print every driver package change in pacman.log, oldest first
+int printDriverHistory()
+{
+    PacmanLogAnalyzer analyzer;
+    QTextStream out(stdout);
+
+    for (const DriverTransaction &t : analyzer.history()) {
+        out << t.started.toString("yyyy-MM-dd HH:mm:ss") << "  "
+            << (t.command.isEmpty() ? QString("(no command logged)") : t.command);
+        if (t.durationMs >= 0)
+            out << "  [" << t.durationMs / 1000 << " s]";
+        out << "\n";
+
+        for (const PackageChange &c : t.changes) {
+            out << "    " << PacmanLogAnalyzer::actionName(c.action).leftJustified(12) << c.package << ' ';
+            if (c.action == PackageChange::Action::Upgraded || c.action == PackageChange::Action::Downgraded)
+                out << c.oldVersion << " -> " << c.newVersion;
+            else
+                out << (c.newVersion.isEmpty() ? c.oldVersion : c.newVersion);
+            out << "\n";
+        }
+        for (const HookRun &h : t.hooks) {
+            out << "    " << QString("hook").leftJustified(12) << h.name;
+            if (h.durationMs >= 0)
+                out << "  [" << h.durationMs / 1000 << " s]";
+            out << "\n";
+        }
+    }
+    return 0;
+}
+
+int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    setApplicationInfo();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("RSCN OS Driver Manager");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption exportMetrics(
+        "export-metrics",
+        QString("Scan drivers and write Prometheus metrics to <file>, "
+                "e.g. %1 for the node_exporter textfile collector.")
+            .arg(MetricsExporter::defaultOutputPath()),
+        "file");
+    parser.addOption(exportMetrics);
+
+    QCommandLineOption driverHistory(
+        "driver-history",
+        QString("List driver package installs, upgrades and removals from %1, "
+                "with transaction and DKMS hook durations.")
+            .arg(PacmanLogAnalyzer::defaultLogPath()));
+    parser.addOption(driverHistory);
+    parser.process(app);
+
+    if (parser.isSet(driverHistory))
+        return printDriverHistory();
+
+    HardwareDetector detector;
+    PackageManager packageManager;
+
+    MetricsExporter exporter;
+    exporter.scan(detector, packageManager);
+    exporter.loadOperations();
+
+    return exporter.writeTo(parser.value(exportMetrics)) ? 0 : 1;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
+    if (isHeadlessInvocation(argc, argv))
+        return runHeadless(argc, argv);
+
     QApplication app(argc, argv);
-    app.setApplicationName("RSCN Drivers");
-    app.setApplicationVersion("1.0.0");
-    app.setOrganizationName("RSCN");
+    setApplicationInfo();
     app.setWindowIcon(QIcon(":/icons/rscn-drivers.svg"));
 
+    // Write a system-access recording while Qt is still up
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+        SystemAccess::instance().flush();
+    });
+
     MainWindow window;
     window.show();
 
@@ -9,19 +9,116 @@
  */
 
 #include "mainwindow.h"
+#include "driverhistorymodel.h"
+#include "operationlogmodel.h"
+#include "operationlogview.h"
+#include "usbhotplugmonitor.h"
 
 #include <QDebug>
+#include <QHeaderView>
+#include <QTabWidget>
+#include <QTableView>
 #include <QTimer>
 
+namespace {
+
+void printProfiles(const QList<DriverProfile> &profiles)
+{
+    qDebug() << "  Available driver profiles:" << profiles.size();
+    for (const DriverProfile &p : profiles) {
+        QString status;
+        switch (p.installStatus) {
+        case InstallStatus::FullyInstalled:
+            status = "[Installed]";
+            break;
+        case InstallStatus::PartiallyInstalled:
+            status = "[Partial]";
+            break;
+        case InstallStatus::NotInstalled:
+            status = "[Not Installed]";
+            break;
+        }
+
+        QString activeStr = p.active ? " (IN USE)" : "";
+        QString recStr = p.recommended ? " *Recommended*" : "";
+        QString typeStr = (p.type == DriverType::Proprietary) ? "proprietary" : "open-source";
+
+        qDebug().noquote() << "    -" << p.displayName
+                           << status << activeStr << recStr
+                           << "(" << typeStr << ")";
+        qDebug().noquote() << "      Packages:" << p.requiredPackages.join(", ");
+        if (!p.firmwarePackages.isEmpty())
+            qDebug().noquote() << "      Firmware:" << p.firmwarePackages.join(", ");
+        if (!p.kernelParameters.isEmpty())
+            qDebug().noquote() << "      Kernel parameters:" << p.kernelParameters.join(" ");
+    }
+}
+
+/// Repository packages named after the vendor that no profile lists, e.g.
+/// nvidia-open or vulkan-intel variants
+void printRepositoryPackages(const QString &vendor, const QList<DriverProfile> &profiles,
+                             PackageManager &packageManager)
+{
+    QStringList listed;
+    for (const DriverProfile &p : profiles)
+        listed << p.requiredPackages << p.optionalPackages;
+
+    QStringList others;
+    for (const SyncPackage &pkg : packageManager.searchRepositories(vendor)) {
+        if (pkg.name.contains(vendor, Qt::CaseInsensitive) && !listed.contains(pkg.name))
+            others.append(pkg.repo + "/" + pkg.name);
+    }
+    if (!others.isEmpty())
+        qDebug().noquote() << "  Other" << vendor << "packages in the repositories:" << others.join(", ");
+}
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_detector(new HardwareDetector(this))
     , m_packageManager(new PackageManager(this))
+    , m_logModel(new OperationLogModel(this))
+    , m_tabs(new QTabWidget(this))
+    , m_logView(new OperationLogView(this))
+    , m_historyView(new QTableView(this))
+    , m_historyModel(new DriverHistoryModel(this))
+    , m_usbMonitor(new UsbHotplugMonitor(this))
 {
     setWindowTitle(tr("RSCN Drivers"));
     setMinimumSize(680, 480);
     resize(780, 520);
 
+    m_logView->setLogModel(m_logModel);
+    m_tabs->addTab(m_logView, tr("Operation Log"));
+
+    m_historyView->setModel(m_historyModel);
+    m_historyView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_historyView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_historyView->verticalHeader()->hide();
+    m_historyView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_historyView->horizontalHeader()->setStretchLastSection(true);
+    m_tabs->addTab(m_historyView, tr("Driver History"));
+    setCentralWidget(m_tabs);
+
+    // Collect operation output for the log viewer; each operation starts fresh
+    m_logModel->setSpillToDisk(true);
+    connect(m_packageManager, &PackageManager::operationStarted,
+            m_logModel, &OperationLogModel::clear);
+    connect(m_packageManager, &PackageManager::operationOutput,
+            m_logModel, &OperationLogModel::appendLine);
+
+    // Only the log lines a finished operation appended are parsed
+    connect(m_packageManager, &PackageManager::operationFinished,
+            m_historyModel, &DriverHistoryModel::refresh);
+    connect(m_historyModel, &DriverHistoryModel::refreshed, this, [this]() {
+        qDebug() << "Driver history:" << m_historyModel->rowCount() << "package changes in pacman.log";
+    });
+
+    // USB adapters come and go; update just those instead of rescanning
+    connect(m_usbMonitor, &UsbHotplugMonitor::devicesChanged,
+            this, &MainWindow::updateUsbDevices);
+
     // Trigger hardware scan after the event loop starts
     QTimer::singleShot(0, this, &MainWindow::scanHardware);
 }
@@ -32,14 +129,19 @@ MainWindow::~MainWindow()
 
 void MainWindow::scanHardware()
 {
-    qDebug() << "=== Scanning GPU hardware ===";
+    qDebug() << "=== Scanning hardware ===";
+
+    // Listen before enumerating, so an adapter plugged in while the scan
+    // runs is not missed; its events are handled once the scan returns
+    m_usbMonitor->start();
 
-    m_gpuDevices = m_detector->detectGpus();
+    // One lspci pass serves every device class
+    const DetectedDevices devices = m_detector->detectDevices();
+    m_gpuDevices = devices.gpus;
+    m_networkDevices = devices.network;
 
-    if (m_gpuDevices.isEmpty()) {
+    if (m_gpuDevices.isEmpty())
         qDebug() << "No GPU devices detected.";
-        return;
-    }
 
     for (const GpuDevice &gpu : m_gpuDevices) {
         qDebug() << "";
@@ -49,37 +151,84 @@ void MainWindow::scanHardware()
         qDebug() << "  Architecture:  " << HardwareDetector::archToString(gpu.architecture);
         qDebug() << "  Kernel Driver: " << gpu.kernelDriver;
         qDebug() << "  Kernel Modules:" << gpu.kernelModules.join(", ");
+        if (HardwareDetector::supportsRuntimeD3(gpu)) {
+            const QString status = HardwareDetector::runtimePowerStatus(gpu.pciSlot);
+            qDebug() << "  Runtime PM:    " << (status.isEmpty() ? QString("unknown") : status);
+        }
 
         // Get matching driver profiles with install status
         QList<DriverProfile> profiles =
             DriverProfileManager::getProfilesForDevice(gpu, *m_packageManager);
 
-        qDebug() << "  Available driver profiles:" << profiles.size();
-        for (const DriverProfile &p : profiles) {
-            QString status;
-            switch (p.installStatus) {
-            case InstallStatus::FullyInstalled:
-                status = "[Installed]";
-                break;
-            case InstallStatus::PartiallyInstalled:
-                status = "[Partial]";
-                break;
-            case InstallStatus::NotInstalled:
-                status = "[Not Installed]";
-                break;
-            }
-
-            QString activeStr = p.active ? " (IN USE)" : "";
-            QString recStr = p.recommended ? " *Recommended*" : "";
-            QString typeStr = (p.type == DriverType::Proprietary) ? "proprietary" : "open-source";
-
-            qDebug().noquote() << "    -" << p.displayName
-                               << status << activeStr << recStr
-                               << "(" << typeStr << ")";
-            qDebug().noquote() << "      Packages:" << p.requiredPackages.join(", ");
+        printProfiles(profiles);
+        printRepositoryPackages(gpu.vendor, profiles, *m_packageManager);
+    }
+
+    for (const NetworkDevice &net : m_networkDevices) {
+        qDebug() << "";
+        qDebug() << (net.wireless ? "Wireless:" : "Ethernet:") << net.vendor << net.model;
+        qDebug() << "  PCI Slot:      " << net.pciSlot;
+        qDebug() << "  PCI ID:        " << net.pciId;
+        qDebug() << "  Kernel Driver: " << net.kernelDriver;
+        qDebug() << "  Kernel Modules:" << net.kernelModules.join(", ");
+
+        const QList<DriverProfile> profiles =
+            DriverProfileManager::getProfilesForNetworkDevice(net, *m_packageManager);
+        if (profiles.isEmpty()) {
+            qDebug() << "  No extra driver needed.";
+            continue;
         }
+        printProfiles(profiles);
     }
 
+    m_usbDevices.clear();
+    for (const UsbDevice &usb : m_detector->detectUsbDevices()) {
+        m_usbDevices.insert(usb.sysfsName, usb);
+        printUsbDevice(usb);
+    }
+
+    // Parsed in the background; logged when it is done
+    m_historyModel->refresh();
+
     qDebug() << "";
     qDebug() << "=== Scan complete ===";
 }
+
+void MainWindow::updateUsbDevices(const QStringList &changed, const QStringList &removed)
+{
+    for (const QString &name : removed) {
+        if (m_usbDevices.remove(name))
+            qDebug() << "USB device removed:" << name;
+    }
+
+    for (const QString &name : changed) {
+        const std::optional<UsbDevice> usb = m_detector->detectUsbDevice(name);
+        if (!usb) {
+            m_usbDevices.remove(name);
+            continue;
+        }
+        // Events from during the scan may concern devices it already listed
+        const auto known = m_usbDevices.constFind(name);
+        if (known != m_usbDevices.cend() && known->usbId == usb->usbId
+            && known->kernelDriver == usb->kernelDriver)
+            continue;
+        m_usbDevices.insert(name, *usb);
+        printUsbDevice(*usb);
+    }
+}
+
+void MainWindow::printUsbDevice(const UsbDevice &device)
+{
+    const QList<DriverProfile> profiles =
+        DriverProfileManager::getProfilesForUsbDevice(device, *m_packageManager);
+    // Only adapters we have drivers for are of interest
+    if (profiles.isEmpty())
+        return;
+
+    qDebug() << "";
+    qDebug() << "USB:" << device.vendor << device.product;
+    qDebug() << "  Bus Path:      " << device.sysfsName;
+    qDebug() << "  USB ID:        " << device.usbId;
+    qDebug() << "  Kernel Driver: " << device.kernelDriver;
+    printProfiles(profiles);
+}
@@ -12,11 +12,19 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QMap>
 
 #include "hardwaredetector.h"
 #include "driverprofile.h"
 #include "packagemanager.h"
 
+class DriverHistoryModel;
+class OperationLogModel;
+class OperationLogView;
+class QTabWidget;
+class QTableView;
+class UsbHotplugMonitor;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -28,9 +36,23 @@ public:
 private:
     void scanHardware();
 
+    /// Re-read only the USB devices a hot-plug event concerns
+    void updateUsbDevices(const QStringList &changed, const QStringList &removed);
+
+    /// Log a USB device with its matching driver profiles
+    void printUsbDevice(const UsbDevice &device);
+
     HardwareDetector *m_detector;
     PackageManager *m_packageManager;
+    OperationLogModel *m_logModel;
+    QTabWidget *m_tabs;
+    OperationLogView *m_logView;
+    QTableView *m_historyView;
+    DriverHistoryModel *m_historyModel;
+    UsbHotplugMonitor *m_usbMonitor;
     QList<GpuDevice> m_gpuDevices;
+    QList<NetworkDevice> m_networkDevices;
+    QMap<QString, UsbDevice> m_usbDevices; // by sysfs name
 };
 
 #endif // MAINWINDOW_H
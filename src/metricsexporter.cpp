@@ -0,0 +1,202 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "metricsexporter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <pwd.h>
+#include <unistd.h>
+
+QString MetricsExporter::defaultOutputPath()
+{
+    return "/var/lib/prometheus/node-exporter/rscn-drivers.prom";
+}
+
+void MetricsExporter::scan(HardwareDetector &detector, PackageManager &packageManager)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_gpus.clear();
+    const QList<GpuDevice> gpus = detector.detectGpus();
+    for (const GpuDevice &gpu : gpus) {
+        GpuMetrics metrics;
+        metrics.device = gpu;
+
+        const QList<DriverProfile> profiles =
+            DriverProfileManager::getProfilesForDevice(gpu, packageManager);
+        for (const DriverProfile &p : profiles) {
+            if (p.active && metrics.activeProfile.isEmpty())
+                metrics.activeProfile = p.id;
+            if (p.recommended && metrics.recommendedProfile.isEmpty())
+                metrics.recommendedProfile = p.id;
+        }
+        m_gpus.append(metrics);
+    }
+
+    m_scanMs = timer.elapsed();
+}
+
+QString MetricsExporter::render() const
+{
+    QString out;
+    QTextStream s(&out);
+
+    s << "# HELP rscn_drivers_gpu_info Detected GPU and its driver state.\n"
+      << "# TYPE rscn_drivers_gpu_info gauge\n";
+    for (const GpuMetrics &m : m_gpus) {
+        s << "rscn_drivers_gpu_info{"
+          << "slot=\"" << escapeLabel(m.device.pciSlot) << "\","
+          << "pci_id=\"" << escapeLabel(m.device.pciId) << "\","
+          << "vendor=\"" << escapeLabel(m.device.vendor) << "\","
+          << "model=\"" << escapeLabel(m.device.model) << "\","
+          << "architecture=\"" << escapeLabel(HardwareDetector::archToString(m.device.architecture)) << "\","
+          << "kernel_driver=\"" << escapeLabel(m.device.kernelDriver) << "\","
+          << "active_profile=\"" << escapeLabel(m.activeProfile) << "\","
+          << "recommended_profile=\"" << escapeLabel(m.recommendedProfile) << "\"} 1\n";
+    }
+
+    s << "# HELP rscn_drivers_gpu_recommended_active Whether the active driver profile is the recommended one.\n"
+      << "# TYPE rscn_drivers_gpu_recommended_active gauge\n";
+    for (const GpuMetrics &m : m_gpus) {
+        const bool match = !m.activeProfile.isEmpty() && m.activeProfile == m.recommendedProfile;
+        s << "rscn_drivers_gpu_recommended_active{slot=\"" << escapeLabel(m.device.pciSlot)
+          << "\"} " << (match ? 1 : 0) << "\n";
+    }
+
+    if (m_scanMs >= 0) {
+        s << "# HELP rscn_drivers_scan_duration_seconds Time taken to detect GPUs and match driver profiles.\n"
+          << "# TYPE rscn_drivers_scan_duration_seconds gauge\n"
+          << "rscn_drivers_scan_duration_seconds " << m_scanMs / 1000.0 << "\n";
+    }
+
+    // Operation timings from the journals
+    if (!m_operations.isEmpty()) {
+        s << "# HELP rscn_drivers_operation_duration_seconds Time spent in package operations.\n"
+          << "# TYPE rscn_drivers_operation_duration_seconds summary\n";
+        for (auto it = m_operations.cbegin(); it != m_operations.cend(); ++it) {
+            const QString labels = "{operation=\"" + escapeLabel(it.key()) + "\"}";
+            s << "rscn_drivers_operation_duration_seconds_sum" << labels << " "
+              << QString::number(it->totals.durationMs / 1000.0, 'f', 3) << "\n"
+              << "rscn_drivers_operation_duration_seconds_count" << labels << " " << it->totals.count << "\n";
+        }
+    }
+
+    struct Family {
+        const char *name;
+        const char *help;
+        const char *type;
+        QString (*value)(const OperationMetrics &);
+    };
+    static const Family families[] = {
+        {"rscn_drivers_operation_failures_total", "Number of package operations that failed.", "counter",
+         [](const OperationMetrics &m) { return QString::number(m.totals.failures); }},
+        {"rscn_drivers_operation_last_duration_seconds", "Duration of the most recent package operation.", "gauge",
+         [](const OperationMetrics &m) { return QString::number(m.lastMs / 1000.0); }},
+        {"rscn_drivers_operation_last_success", "Whether the most recent package operation succeeded.", "gauge",
+         [](const OperationMetrics &m) { return QString::number(m.lastSuccess ? 1 : 0); }},
+        {"rscn_drivers_operation_last_timestamp_seconds", "Unix time the most recent package operation finished.", "gauge",
+         [](const OperationMetrics &m) { return QString::number(m.lastFinished.toSecsSinceEpoch()); }},
+    };
+
+    for (const Family &f : families) {
+        if (m_operations.isEmpty())
+            break;
+        s << "# HELP " << f.name << " " << f.help << "\n"
+          << "# TYPE " << f.name << " " << f.type << "\n";
+        for (auto it = m_operations.cbegin(); it != m_operations.cend(); ++it)
+            s << f.name << "{operation=\"" << escapeLabel(it.key()) << "\"} " << f.value(*it) << "\n";
+    }
+
+    s << "# HELP rscn_drivers_export_timestamp_seconds Unix time this file was written.\n"
+      << "# TYPE rscn_drivers_export_timestamp_seconds gauge\n"
+      << "rscn_drivers_export_timestamp_seconds " << QDateTime::currentSecsSinceEpoch() << "\n";
+
+    return out;
+}
+
+bool MetricsExporter::writeTo(const QString &path) const
+{
+    // QSaveFile writes to a temporary file in the same directory and renames
+    // it over the target on commit, so the collector never sees a partial file.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Cannot write metrics to" << path << ":" << file.errorString();
+        return false;
+    }
+
+    file.write(render().toUtf8());
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner |
+                        QFileDevice::ReadGroup | QFileDevice::ReadOther);
+    if (!file.commit()) {
+        qWarning() << "Cannot write metrics to" << path << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QStringList MetricsExporter::defaultJournalDirectories()
+{
+    QStringList directories = {OperationJournal::defaultDirectory()};
+    if (geteuid() != 0)
+        return directories;
+
+    // The GUI runs as the user, who journals under their own state directory
+    setpwent();
+    while (const passwd *pw = getpwent()) {
+        if (pw->pw_uid == 0 || !pw->pw_dir)
+            continue;
+        const QString directory = QString::fromLocal8Bit(pw->pw_dir) + "/.local/state/rscn-drivers";
+        if (!directories.contains(directory) && QFileInfo::exists(directory))
+            directories.append(directory);
+    }
+    endpwent();
+    return directories;
+}
+
+void MetricsExporter::loadOperations(const QStringList &journalDirectories)
+{
+    m_operations.clear();
+    for (const QString &directory : journalDirectories) {
+        const OperationJournal journal(directory);
+
+        const QMap<QString, OperationTotals> totals = journal.totals();
+        for (auto it = totals.cbegin(); it != totals.cend(); ++it) {
+            OperationTotals &t = m_operations[it.key()].totals;
+            t.count += it->count;
+            t.failures += it->failures;
+            t.durationMs += it->durationMs;
+        }
+
+        for (const JournalIndexEntry &entry : journal.entries()) {
+            OperationMetrics &m = m_operations[PackageManager::operationName(entry.type)];
+            if (m.lastFinished.isValid() && entry.finished <= m.lastFinished)
+                continue;
+            m.lastMs = entry.started.isValid() ? entry.started.msecsTo(entry.finished) : 0;
+            m.lastSuccess = entry.exitCode == 0;
+            m.lastFinished = entry.finished;
+        }
+    }
+}
+
+QString MetricsExporter::escapeLabel(const QString &value)
+{
+    QString escaped = value;
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    escaped.replace('\n', "\\n");
+    return escaped;
+}
@@ -0,0 +1,79 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QDateTime>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "hardwaredetector.h"
+#include "driverprofile.h"
+#include "operationjournal.h"
+#include "packagemanager.h"
+
+/// Driver state of one GPU as exported to Prometheus
+struct GpuMetrics {
+    GpuDevice device;
+    QString activeProfile;       // profile id in use, empty if none matched
+    QString recommendedProfile;  // recommended profile id
+};
+
+/// Timings of one operation type from the journals
+struct OperationMetrics {
+    OperationTotals totals;  // all operations ever journaled
+    qint64 lastMs = 0;
+    bool lastSuccess = false;
+    QDateTime lastFinished;
+};
+
+/// Writes driver state and operation timings in the Prometheus text format
+/// for node_exporter's textfile collector.
+///
+/// Operation timings are read from the operation journals, so an export
+/// running as root (e.g. from cron) reports the operations users ran from
+/// the GUI. Counts and durations come from the journals' running totals and
+/// never decrease; the most recent operation is found in the indexes.
+class MetricsExporter
+{
+public:
+    /// Default location read by node_exporter's textfile collector
+    static QString defaultOutputPath();
+
+    /// Detect GPUs and match profiles, timing the whole pipeline
+    void scan(HardwareDetector &detector, PackageManager &packageManager);
+
+    /// Render all metrics in the Prometheus text exposition format
+    QString render() const;
+
+    /// Atomically replace `path` with the rendered metrics
+    bool writeTo(const QString &path) const;
+
+    /// Journals to read operation timings from: the caller's own and, for
+    /// root, ~/.local/state/rscn-drivers of every account in the passwd
+    /// database
+    static QStringList defaultJournalDirectories();
+
+    /// Aggregate the operations in the journals by type
+    void loadOperations(const QStringList &journalDirectories = defaultJournalDirectories());
+
+private:
+    /// Escape a label value per the exposition format
+    static QString escapeLabel(const QString &value);
+
+    QList<GpuMetrics> m_gpus;
+    qint64 m_scanMs = -1;
+    QMap<QString, OperationMetrics> m_operations; // by PackageManager::operationName()
+};
+
+#endif // METRICSEXPORTER_H
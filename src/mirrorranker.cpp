@@ -0,0 +1,168 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "mirrorranker.h"
+#include "processexecutor.h"
+#include "systemaccess.h"
+
+#include <QSysInfo>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Bytes requested from each mirror
+constexpr qint64 kProbeBytes = 256 * 1024;
+
+/// Download size the estimate is made for; large enough that throughput
+/// dominates, as for nvidia-utils and friends
+constexpr double kReferenceBytes = 64.0 * 1024 * 1024;
+
+} // namespace
+
+MirrorRanker::MirrorRanker(const QString &mirrorlistPath)
+    : m_mirrorlistPath(mirrorlistPath)
+{
+}
+
+QString MirrorRanker::defaultMirrorlist()
+{
+    const QString env = qEnvironmentVariable("RSCN_MIRRORLIST");
+    return env.isEmpty() ? QStringLiteral("/etc/pacman.d/mirrorlist") : env;
+}
+
+bool MirrorRanker::isMirrorlistOverridden()
+{
+    return !qEnvironmentVariableIsEmpty("RSCN_MIRRORLIST");
+}
+
+QStringList MirrorRanker::servers() const
+{
+    const std::optional<QByteArray> content = SystemAccess::instance().readFile(m_mirrorlistPath);
+    if (!content)
+        return {};
+
+    // "Server = https://mirror.example/archlinux/$repo/os/$arch"
+    QStringList servers;
+    for (const QByteArray &rawLine : content->split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+        if (!line.startsWith("Server"))
+            continue;
+        const qsizetype eq = line.indexOf('=');
+        if (eq < 0 || line.first(eq).trimmed() != "Server")
+            continue;
+        const QString server = QString::fromUtf8(line.sliced(eq + 1).trimmed());
+        if (!server.isEmpty() && !servers.contains(server))
+            servers.append(server);
+    }
+    return servers;
+}
+
+QString MirrorRanker::probeUrl(const QString &server)
+{
+    QString url = server;
+    url.replace("$repo", "extra");
+    url.replace("$arch", QSysInfo::currentCpuArchitecture());
+    return url + "/extra.db";
+}
+
+QList<MirrorProbe> MirrorRanker::probe(int maxMirrors, int timeoutMs) const
+{
+    const QStringList candidates = servers().mid(0, maxMirrors);
+    return evaluateProbes(candidates,
+                          ProcessExecutor::instance().runAll(probeCommands(candidates, timeoutMs)));
+}
+
+QFuture<QList<MirrorProbe>> MirrorRanker::probeAsync(int maxMirrors, int timeoutMs) const
+{
+    const QStringList candidates = servers().mid(0, maxMirrors);
+    return ProcessExecutor::instance()
+        .submitAll(probeCommands(candidates, timeoutMs))
+        .then([candidates](const QList<CommandResult> &results) {
+            return evaluateProbes(candidates, results);
+        });
+}
+
+QList<CommandSpec> MirrorRanker::probeCommands(const QStringList &servers, int timeoutMs)
+{
+    QList<CommandSpec> specs;
+    for (const QString &server : servers) {
+        CommandSpec spec;
+        spec.program = "curl";
+        spec.args = {"--silent", "--location", "--output", "/dev/null",
+                     "--range", QString("0-%1").arg(kProbeBytes - 1),
+                     "--max-time", QString::number(timeoutMs / 1000.0, 'f', 1),
+                     "--write-out", "%{http_code} %{time_starttransfer} %{speed_download}",
+                     probeUrl(server)};
+        spec.timeoutMs = timeoutMs + 1000;
+        specs.append(spec);
+    }
+    return specs;
+}
+
+QList<MirrorProbe> MirrorRanker::evaluateProbes(const QStringList &servers,
+                                                const QList<CommandResult> &results)
+{
+    QList<MirrorProbe> probes;
+    for (qsizetype i = 0; i < servers.size(); ++i) {
+        MirrorProbe probe;
+        probe.server = servers.at(i);
+
+        const QList<QByteArray> fields = results.at(i).output.trimmed().split(' ');
+        if (results.at(i).exitCode == 0 && fields.size() == 3) {
+            const int httpCode = fields.at(0).toInt();
+            // file:// mirrors report code 0
+            probe.reachable = httpCode == 200 || httpCode == 206 || httpCode == 0;
+            probe.latencyMs = qint64(fields.at(1).toDouble() * 1000);
+            probe.bytesPerSecond = fields.at(2).toDouble();
+        }
+        if (probe.reachable && probe.bytesPerSecond > 0) {
+            probe.estimatedMs = probe.latencyMs
+                + qint64(kReferenceBytes / probe.bytesPerSecond * 1000);
+        } else {
+            probe.reachable = false;
+        }
+        probes.append(probe);
+    }
+    return probes;
+}
+
+QStringList MirrorRanker::rankedServers(QList<MirrorProbe> probes)
+{
+    probes.erase(std::remove_if(probes.begin(), probes.end(),
+                                [](const MirrorProbe &p) { return !p.reachable; }),
+                 probes.end());
+    std::stable_sort(probes.begin(), probes.end(), [](const MirrorProbe &a, const MirrorProbe &b) {
+        return a.estimatedMs < b.estimatedMs;
+    });
+
+    QStringList ranked;
+    for (const MirrorProbe &probe : std::as_const(probes))
+        ranked.append(probe.server);
+    return ranked;
+}
+
+int MirrorRanker::recommendedParallelDownloads(const QList<MirrorProbe> &probes)
+{
+    qint64 bestLatency = -1;
+    qint64 bestEstimate = -1;
+    for (const MirrorProbe &probe : probes) {
+        if (probe.reachable && (bestEstimate < 0 || probe.estimatedMs < bestEstimate)) {
+            bestEstimate = probe.estimatedMs;
+            bestLatency = probe.latencyMs;
+        }
+    }
+    if (bestLatency < 0)
+        return 5; // pacman's default
+
+    // A low-latency mirror saturates the link with few streams
+    return qBound(2, 2 + int(std::lround(bestLatency / 50.0)), 10);
+}
@@ -0,0 +1,80 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef MIRRORRANKER_H
+#define MIRRORRANKER_H
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "processexecutor.h"
+
+/// Measured performance of one mirror
+struct MirrorProbe {
+    QString server;            // Server line as in the mirrorlist, with $repo/$arch
+    bool reachable = false;    // answered the range request with 200/206
+    qint64 latencyMs = -1;     // time to first byte
+    double bytesPerSecond = 0; // throughput of the range request
+    qint64 estimatedMs = -1;   // expected time for a reference download
+};
+
+/// Ranks the configured pacman mirrors by probing each with a small HTTP
+/// range request (curl, run concurrently through ProcessExecutor).
+///
+/// The ranking only reorders servers that are already in the mirrorlist;
+/// the privileged helper re-validates it before writing the temporary
+/// pacman configuration for a transaction. Point $RSCN_MIRRORLIST at a file
+/// listing a local stand-in mirror to exercise the probes without network
+/// access; the helper would reject its servers, so with the override only
+/// the ParallelDownloads value is passed on.
+class MirrorRanker
+{
+public:
+    explicit MirrorRanker(const QString &mirrorlistPath = defaultMirrorlist());
+
+    /// $RSCN_MIRRORLIST, or /etc/pacman.d/mirrorlist
+    static QString defaultMirrorlist();
+
+    /// Whether $RSCN_MIRRORLIST replaces the system mirrorlist
+    static bool isMirrorlistOverridden();
+
+    /// Active (uncommented) Server entries, in file order
+    QStringList servers() const;
+
+    /// Probe up to maxMirrors servers concurrently
+    QList<MirrorProbe> probe(int maxMirrors = 10, int timeoutMs = 3000) const;
+
+    /// Same as probe(), without blocking the calling thread
+    QFuture<QList<MirrorProbe>> probeAsync(int maxMirrors = 10, int timeoutMs = 3000) const;
+
+    /// Reachable servers, fastest estimated download first
+    static QStringList rankedServers(QList<MirrorProbe> probes);
+
+    /// ParallelDownloads value for the best mirror: more concurrent
+    /// transfers the higher its latency, since each stream is latency bound
+    static int recommendedParallelDownloads(const QList<MirrorProbe> &probes);
+
+    /// URL of the probe target for a server: the extra repo database
+    static QString probeUrl(const QString &server);
+
+private:
+    /// One curl range request per server
+    static QList<CommandSpec> probeCommands(const QStringList &servers, int timeoutMs);
+
+    /// Turn the curl results into probes, in server order
+    static QList<MirrorProbe> evaluateProbes(const QStringList &servers,
+                                             const QList<CommandResult> &results);
+
+    QString m_mirrorlistPath;
+};
+
+#endif // MIRRORRANKER_H
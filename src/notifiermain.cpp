@@ -0,0 +1,38 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+#include "updatenotifier.h"
+
+int main(int argc, char *argv[])
+{
+    // QtCore only: the notifier stays resident for the whole session
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RSCN Drivers Notifier");
+    QCoreApplication::setApplicationVersion("1.0.0");
+    QCoreApplication::setOrganizationName("RSCN");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Notifies about driver updates for RSCN Drivers");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption dbPath("dbpath", "Pacman database directory to watch.", "path", "/var/lib/pacman");
+    parser.addOption(dbPath);
+    parser.process(app);
+
+    UpdateNotifier notifier(parser.value(dbPath));
+    if (!notifier.start())
+        return 1;
+
+    return app.exec();
+}
@@ -0,0 +1,311 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "operationjournal.h"
+#include "packagemanager.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <algorithm>
+
+#include <unistd.h>
+
+namespace {
+
+// Every frame in a segment starts with this tag and the payload length
+const char kFrameMagic[4] = {'R', 'J', 'E', '1'};
+constexpr int kFrameHeaderSize = 8;
+
+// IndexRecord serialized with QDataStream: 3*8 + 2*4 + 2*8 bytes
+constexpr int kIndexRecordSize = 48;
+
+QString timestamp(const QDateTime &dt)
+{
+    return dt.isValid() ? dt.toString(Qt::ISODateWithMs) : QString();
+}
+
+QDateTime fromMs(qint64 ms)
+{
+    return ms > 0 ? QDateTime::fromMSecsSinceEpoch(ms) : QDateTime();
+}
+
+} // namespace
+
+OperationJournal::OperationJournal(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+QString OperationJournal::defaultDirectory()
+{
+    if (geteuid() == 0)
+        return "/var/log/rscn-drivers";
+
+    QString stateHome = qEnvironmentVariable("XDG_STATE_HOME");
+    if (stateHome.isEmpty())
+        stateHome = QDir::homePath() + "/.local/state";
+    return stateHome + "/rscn-drivers";
+}
+
+bool OperationJournal::append(OperationRecord &record)
+{
+    if (!QDir().mkpath(m_directory)) {
+        qWarning() << "Cannot create journal directory" << m_directory;
+        return false;
+    }
+
+    // Pick the segment to append to, and the next id
+    QList<quint64> existing = segments();
+    quint64 segment = 0;
+    quint64 nextId = 1;
+    if (!existing.isEmpty()) {
+        segment = existing.last();
+        const QList<IndexRecord> index = readIndex(segment);
+        nextId = index.isEmpty() ? segment : index.last().id + 1;
+        if (QFileInfo(segmentPath(segment)).size() >= kSegmentSize)
+            segment = 0;
+    }
+    record.id = nextId;
+    if (segment == 0)
+        segment = nextId;
+
+    QJsonObject obj;
+    obj["id"] = QString::number(record.id);
+    obj["type"] = PackageManager::operationName(record.type);
+    obj["program"] = record.program;
+    obj["arguments"] = QJsonArray::fromStringList(record.arguments);
+    obj["requested"] = timestamp(record.requested);
+    obj["started"] = timestamp(record.started);
+    obj["firstOutput"] = timestamp(record.firstOutput);
+    obj["finished"] = timestamp(record.finished);
+    obj["exitCode"] = record.exitCode;
+    obj["success"] = record.success;
+    obj["error"] = record.errorMessage;
+    obj["output"] = QString::fromUtf8(record.output);
+
+    const QByteArray payload = qCompress(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+
+    QFile segmentFile(segmentPath(segment));
+    if (!segmentFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Cannot open journal segment" << segmentFile.fileName()
+                   << ":" << segmentFile.errorString();
+        return false;
+    }
+    const qint64 offset = segmentFile.size();
+
+    QByteArray frame(kFrameMagic, sizeof(kFrameMagic));
+    const quint32 length = qToBigEndian(quint32(payload.size()));
+    frame.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    frame.append(payload);
+    if (segmentFile.write(frame) != frame.size())
+        return false;
+    segmentFile.close();
+
+    // The index entry is written last; a frame without one is ignored
+    QFile indexFile(indexPath(segment));
+    if (!indexFile.open(QIODevice::ReadWrite))
+        return false;
+    // Drop a record torn by a crash mid-write, or every record after it
+    // would be read at the wrong offset
+    const qint64 complete = indexFile.size() - indexFile.size() % kIndexRecordSize;
+    if (complete != indexFile.size() && !indexFile.resize(complete))
+        return false;
+    if (!indexFile.seek(complete))
+        return false;
+    QDataStream index(&indexFile);
+    index << quint64(record.id)
+          << qint64(record.started.isValid() ? record.started.toMSecsSinceEpoch() : 0)
+          << qint64(record.finished.isValid() ? record.finished.toMSecsSinceEpoch() : 0)
+          << qint32(record.type)
+          << qint32(record.exitCode)
+          << qint64(offset)
+          << qint64(frame.size());
+    indexFile.close();
+
+    addToTotals(record);
+
+    if (segment == record.id)
+        prune();
+    return true;
+}
+
+QMap<QString, OperationTotals> OperationJournal::totals() const
+{
+    // One "<operation> <count> <failures> <duration ms>" line per type
+    QMap<QString, OperationTotals> result;
+    QFile file(totalsPath());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    QTextStream in(&file);
+    QString line;
+    while (in.readLineInto(&line)) {
+        const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        if (fields.size() != 4)
+            continue;
+        OperationTotals t;
+        t.count = fields.at(1).toLongLong();
+        t.failures = fields.at(2).toLongLong();
+        t.durationMs = fields.at(3).toLongLong();
+        result.insert(fields.at(0), t);
+    }
+    return result;
+}
+
+void OperationJournal::addToTotals(const OperationRecord &record)
+{
+    QMap<QString, OperationTotals> current = totals();
+    OperationTotals &t = current[PackageManager::operationName(record.type)];
+    ++t.count;
+    if (!record.success)
+        ++t.failures;
+    if (record.started.isValid() && record.finished.isValid())
+        t.durationMs += record.started.msecsTo(record.finished);
+
+    QSaveFile file(totalsPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Cannot write journal totals" << file.fileName();
+        return;
+    }
+    QTextStream out(&file);
+    for (auto it = current.cbegin(); it != current.cend(); ++it)
+        out << it.key() << ' ' << it->count << ' ' << it->failures << ' ' << it->durationMs << '\n';
+    out.flush();
+    if (!file.commit())
+        qWarning() << "Cannot write journal totals" << file.fileName();
+}
+
+QList<JournalIndexEntry> OperationJournal::entries() const
+{
+    QList<JournalIndexEntry> result;
+    for (quint64 segment : segments()) {
+        for (const IndexRecord &r : readIndex(segment)) {
+            JournalIndexEntry e;
+            e.id = r.id;
+            e.type = OperationType(r.type);
+            e.started = fromMs(r.startedMs);
+            e.finished = fromMs(r.finishedMs);
+            e.exitCode = r.exitCode;
+            result.append(e);
+        }
+    }
+    return result;
+}
+
+std::optional<OperationRecord> OperationJournal::read(quint64 id) const
+{
+    // Segments are named after their first id: the last one not above `id`
+    // is the only one that can contain it.
+    const QList<quint64> all = segments();
+    auto it = std::upper_bound(all.cbegin(), all.cend(), id);
+    if (it == all.cbegin())
+        return std::nullopt;
+    const quint64 segment = *(--it);
+
+    for (const IndexRecord &r : readIndex(segment)) {
+        if (r.id != id)
+            continue;
+
+        QFile file(segmentPath(segment));
+        if (!file.open(QIODevice::ReadOnly) || !file.seek(r.offset))
+            return std::nullopt;
+        const QByteArray frame = file.read(r.length);
+        if (frame.size() != r.length || !frame.startsWith(QByteArray(kFrameMagic, sizeof(kFrameMagic))))
+            return std::nullopt;
+
+        const QJsonObject obj =
+            QJsonDocument::fromJson(qUncompress(frame.mid(kFrameHeaderSize))).object();
+        if (obj.isEmpty())
+            return std::nullopt;
+
+        OperationRecord record;
+        record.id = id;
+        record.type = OperationType(r.type);
+        record.program = obj["program"].toString();
+        for (const QJsonValue &arg : obj["arguments"].toArray())
+            record.arguments.append(arg.toString());
+        record.requested = QDateTime::fromString(obj["requested"].toString(), Qt::ISODateWithMs);
+        record.started = QDateTime::fromString(obj["started"].toString(), Qt::ISODateWithMs);
+        record.firstOutput = QDateTime::fromString(obj["firstOutput"].toString(), Qt::ISODateWithMs);
+        record.finished = QDateTime::fromString(obj["finished"].toString(), Qt::ISODateWithMs);
+        record.exitCode = obj["exitCode"].toInt(-1);
+        record.success = obj["success"].toBool();
+        record.errorMessage = obj["error"].toString();
+        record.output = obj["output"].toString().toUtf8();
+        return record;
+    }
+    return std::nullopt;
+}
+
+QList<quint64> OperationJournal::segments() const
+{
+    QList<quint64> ids;
+    const QStringList files = QDir(m_directory).entryList({"segment-*.log"}, QDir::Files);
+    for (const QString &name : files) {
+        bool ok = false;
+        const quint64 id = name.mid(8, name.size() - 12).toULongLong(&ok);
+        if (ok)
+            ids.append(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+QString OperationJournal::segmentPath(quint64 firstId) const
+{
+    return QString("%1/segment-%2.log").arg(m_directory).arg(firstId, 12, 10, QLatin1Char('0'));
+}
+
+QString OperationJournal::indexPath(quint64 firstId) const
+{
+    return QString("%1/segment-%2.idx").arg(m_directory).arg(firstId, 12, 10, QLatin1Char('0'));
+}
+
+QString OperationJournal::totalsPath() const
+{
+    return m_directory + "/totals";
+}
+
+QList<OperationJournal::IndexRecord> OperationJournal::readIndex(quint64 firstId) const
+{
+    QList<IndexRecord> records;
+    QFile file(indexPath(firstId));
+    if (!file.open(QIODevice::ReadOnly))
+        return records;
+
+    // A torn trailing record (crash during append) is ignored
+    const qint64 count = file.size() / kIndexRecordSize;
+    records.reserve(count);
+    QDataStream in(&file);
+    for (qint64 i = 0; i < count; ++i) {
+        IndexRecord r;
+        in >> r.id >> r.startedMs >> r.finishedMs >> r.type >> r.exitCode >> r.offset >> r.length;
+        records.append(r);
+    }
+    return records;
+}
+
+void OperationJournal::prune()
+{
+    const QList<quint64> all = segments();
+    for (qsizetype i = 0; i + kMaxSegments < all.size(); ++i) {
+        QFile::remove(segmentPath(all.at(i)));
+        QFile::remove(indexPath(all.at(i)));
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef OPERATIONJOURNAL_H
+#define OPERATIONJOURNAL_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+enum class OperationType;
+
+/// Everything known about one finished package operation
+struct OperationRecord {
+    quint64 id = 0;                // assigned by OperationJournal::append
+    OperationType type{};
+    QString program;               // e.g. "pkexec"
+    QStringList arguments;         // full argument list
+    QDateTime requested;           // operation was requested
+    QDateTime started;             // process started
+    QDateTime firstOutput;         // first output received (invalid if none)
+    QDateTime finished;            // operation finished
+    int exitCode = -1;             // -1 if the process did not exit normally
+    bool success = false;
+    QString errorMessage;
+    QByteArray output;             // complete merged stdout/stderr
+};
+
+/// Summary of a journal entry, read from the index without touching segments
+struct JournalIndexEntry {
+    quint64 id = 0;
+    OperationType type{};
+    QDateTime started;
+    QDateTime finished;
+    int exitCode = -1;
+};
+
+/// Operations of one type since the journal was created
+struct OperationTotals {
+    qint64 count = 0;
+    qint64 failures = 0;
+    qint64 durationMs = 0;  // started to finished, summed
+};
+
+/// Rotating, append-only journal of package operations.
+///
+/// Entries are appended as individually compressed frames to segment files
+/// named after the id of their first entry. Each segment has a fixed-size
+/// record index next to it, so a single run is found by picking the segment
+/// by name and reading its small index instead of the whole history.
+///
+/// Running totals per operation type are kept in a small file next to the
+/// segments; they only grow, whatever pruning removes.
+class OperationJournal
+{
+public:
+    explicit OperationJournal(const QString &directory = defaultDirectory());
+
+    /// /var/log/rscn-drivers for root, $XDG_STATE_HOME/rscn-drivers otherwise
+    static QString defaultDirectory();
+
+    /// Append a finished operation and assign its id
+    bool append(OperationRecord &record);
+
+    /// Index entries of all retained operations, oldest first
+    QList<JournalIndexEntry> entries() const;
+
+    /// Read back a single operation by id
+    std::optional<OperationRecord> read(quint64 id) const;
+
+    /// Totals by PackageManager::operationName(), including pruned entries
+    QMap<QString, OperationTotals> totals() const;
+
+    /// Rotate to a new segment once the current one exceeds this size
+    static constexpr qint64 kSegmentSize = 4 * 1024 * 1024;
+
+    /// Number of segments kept before the oldest is deleted
+    static constexpr int kMaxSegments = 16;
+
+private:
+    struct IndexRecord {
+        quint64 id;
+        qint64 startedMs;
+        qint64 finishedMs;
+        qint32 type;
+        qint32 exitCode;
+        qint64 offset;
+        qint64 length;
+    };
+
+    /// First entry ids of the existing segments, ascending
+    QList<quint64> segments() const;
+
+    QString segmentPath(quint64 firstId) const;
+    QString indexPath(quint64 firstId) const;
+    QString totalsPath() const;
+
+    /// Add a finished operation to the totals file
+    void addToTotals(const OperationRecord &record);
+
+    QList<IndexRecord> readIndex(quint64 firstId) const;
+
+    /// Delete the oldest segments beyond kMaxSegments
+    void prune();
+
+    QString m_directory;
+};
+
+#endif // OPERATIONJOURNAL_H
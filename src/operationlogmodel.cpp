@@ -0,0 +1,232 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "operationlogmodel.h"
+
+#include <QDebug>
+#include <QTemporaryFile>
+
+OperationLogModel::OperationLogModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(kFlushIntervalMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &OperationLogModel::flushPending);
+
+    setMemoryLineLimit(32 * kChunkSize);
+}
+
+OperationLogModel::~OperationLogModel()
+{
+    delete m_spillFile;
+}
+
+void OperationLogModel::setMemoryLineLimit(int lines)
+{
+    const int chunks = qMax(2, (lines + kChunkSize - 1) / kChunkSize);
+    if (chunks == m_ring.size())
+        return;
+
+    // Re-pack the in-memory chunks into a ring of the new capacity
+    flushPending();
+    while (m_chunkCount > chunks)
+        evictOldestChunk();
+
+    QList<QStringList> ring(chunks);
+    for (int i = 0; i < m_chunkCount; ++i)
+        ring[i] = std::move(chunkAt(i));
+    m_ring = std::move(ring);
+    m_head = 0;
+}
+
+int OperationLogModel::memoryLineLimit() const
+{
+    return int(m_ring.size()) * kChunkSize;
+}
+
+void OperationLogModel::setSpillToDisk(bool enabled)
+{
+    m_spillToDisk = enabled;
+}
+
+int OperationLogModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_spilledLines + memoryLineCount();
+}
+
+QVariant OperationLogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return {};
+
+    int row = index.row();
+    if (row < m_spilledLines)
+        return spilledLine(row);
+
+    row -= m_spilledLines;
+    const int chunk = row / kChunkSize;
+    if (chunk >= m_chunkCount)
+        return {};
+    const QStringList &lines = chunkAt(chunk);
+    const int offset = row % kChunkSize;
+    return offset < lines.size() ? lines.at(offset) : QVariant();
+}
+
+void OperationLogModel::appendLine(const QString &line)
+{
+    m_pending.append(line);
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void OperationLogModel::clear()
+{
+    m_flushTimer.stop();
+    m_pending.clear();
+
+    beginResetModel();
+    for (QStringList &chunk : m_ring)
+        chunk.clear();
+    m_head = 0;
+    m_chunkCount = 0;
+
+    delete m_spillFile;
+    m_spillFile = nullptr;
+    m_spillOffsets.clear();
+    m_spilledLines = 0;
+    m_cachedSpillChunk = -1;
+    m_cachedSpillLines.clear();
+    endResetModel();
+}
+
+void OperationLogModel::flushPending()
+{
+    qsizetype next = 0;
+    while (next < m_pending.size()) {
+        // Make room before inserting, so rows are never removed while an
+        // insertion is in progress
+        if (freeLineCapacity() < kChunkSize)
+            evictOldestChunk();
+
+        const int count = int(qMin<qsizetype>(m_pending.size() - next, freeLineCapacity()));
+        const int first = rowCount();
+        beginInsertRows(QModelIndex(), first, first + count - 1);
+        for (int i = 0; i < count; ++i)
+            pushLine(m_pending.at(next + i));
+        endInsertRows();
+        next += count;
+    }
+    m_pending.clear();
+}
+
+void OperationLogModel::pushLine(const QString &line)
+{
+    if (m_chunkCount == 0 || chunkAt(m_chunkCount - 1).size() >= kChunkSize) {
+        QStringList &fresh = chunkAt(m_chunkCount);
+        fresh.reserve(kChunkSize);
+        ++m_chunkCount;
+    }
+    chunkAt(m_chunkCount - 1).append(line);
+}
+
+void OperationLogModel::evictOldestChunk()
+{
+    if (m_chunkCount == 0)
+        return;
+
+    QStringList &oldest = chunkAt(0);
+    const int lineCount = int(oldest.size());
+
+    if (m_spillToDisk) {
+        if (!m_spillFile) {
+            m_spillFile = new QTemporaryFile;
+            if (!m_spillFile->open()) {
+                qWarning() << "Cannot create log spill file:" << m_spillFile->errorString();
+                delete m_spillFile;
+                m_spillFile = nullptr;
+                m_spillToDisk = false;
+            }
+        }
+    }
+
+    if (m_spillToDisk) {
+        // Rows keep their numbers; the lines just move to disk
+        m_spillFile->seek(m_spillFile->size());
+        m_spillOffsets.append(m_spillFile->pos());
+        m_spillFile->write(oldest.join('\n').toUtf8());
+        m_spillFile->write("\n");
+        m_spilledLines += lineCount;
+
+        oldest.clear();
+        oldest.squeeze();
+        m_head = (m_head + 1) % int(m_ring.size());
+        --m_chunkCount;
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), m_spilledLines, m_spilledLines + lineCount - 1);
+    oldest.clear();
+    oldest.squeeze();
+    m_head = (m_head + 1) % int(m_ring.size());
+    --m_chunkCount;
+    endRemoveRows();
+}
+
+int OperationLogModel::freeLineCapacity() const
+{
+    const int unusedChunks = int(m_ring.size()) - m_chunkCount;
+    const int lastChunkRoom = m_chunkCount > 0 ? kChunkSize - int(chunkAt(m_chunkCount - 1).size()) : 0;
+    return unusedChunks * kChunkSize + lastChunkRoom;
+}
+
+int OperationLogModel::memoryLineCount() const
+{
+    if (m_chunkCount == 0)
+        return 0;
+    // All chunks but the newest are full
+    return (m_chunkCount - 1) * kChunkSize + int(chunkAt(m_chunkCount - 1).size());
+}
+
+QStringList &OperationLogModel::chunkAt(int ringIndex)
+{
+    return m_ring[(m_head + ringIndex) % int(m_ring.size())];
+}
+
+const QStringList &OperationLogModel::chunkAt(int ringIndex) const
+{
+    return m_ring.at((m_head + ringIndex) % int(m_ring.size()));
+}
+
+QString OperationLogModel::spilledLine(int row) const
+{
+    const int chunk = row / kChunkSize;
+
+    if (chunk != m_cachedSpillChunk) {
+        m_cachedSpillChunk = -1;
+        m_cachedSpillLines.clear();
+
+        const qint64 start = m_spillOffsets.at(chunk);
+        const qint64 end = chunk + 1 < m_spillOffsets.size()
+            ? m_spillOffsets.at(chunk + 1) : m_spillFile->size();
+        if (!m_spillFile->seek(start))
+            return {};
+
+        QByteArray bytes = m_spillFile->read(end - start);
+        if (bytes.endsWith('\n'))
+            bytes.chop(1);
+        m_cachedSpillLines = QString::fromUtf8(bytes).split('\n');
+        m_cachedSpillChunk = chunk;
+    }
+
+    const int offset = row % kChunkSize;
+    return offset < m_cachedSpillLines.size() ? m_cachedSpillLines.at(offset) : QString();
+}
@@ -0,0 +1,97 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef OPERATIONLOGMODEL_H
+#define OPERATIONLOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QStringList>
+#include <QTimer>
+
+class QTemporaryFile;
+
+/// List model holding the output of package operations.
+///
+/// Lines are kept in fixed-size chunks in a bounded ring buffer, so memory
+/// stays flat no matter how much a DKMS build prints. Appends are queued and
+/// inserted in one batch per frame. Once the in-memory limit is reached the
+/// oldest chunk is either dropped or, with spill enabled, written to a
+/// temporary file and read back on demand when scrolled into view.
+class OperationLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit OperationLogModel(QObject *parent = nullptr);
+    ~OperationLogModel() override;
+
+    /// Number of lines kept in memory (rounded up to whole chunks)
+    void setMemoryLineLimit(int lines);
+    int memoryLineLimit() const;
+
+    /// Keep evicted lines in a temporary file instead of dropping them
+    void setSpillToDisk(bool enabled);
+    bool spillToDisk() const { return m_spillToDisk; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+public slots:
+    /// Queue a line for insertion; connect to PackageManager::operationOutput
+    void appendLine(const QString &line);
+
+    /// Remove all lines, including any spilled to disk
+    void clear();
+
+private:
+    static constexpr int kChunkSize = 1024;
+    static constexpr int kFlushIntervalMs = 16;  // one frame at 60 fps
+
+    /// Insert all queued lines with a single beginInsertRows/endInsertRows
+    void flushPending();
+
+    /// Push one line into the ring, opening a new chunk when needed.
+    /// The caller guarantees freeLineCapacity() > 0.
+    void pushLine(const QString &line);
+
+    /// Lines that fit before the oldest chunk has to be evicted
+    int freeLineCapacity() const;
+
+    /// Move the oldest chunk out of memory (spill or drop)
+    void evictOldestChunk();
+
+    /// Lines currently held in memory
+    int memoryLineCount() const;
+
+    QStringList &chunkAt(int ringIndex);
+    const QStringList &chunkAt(int ringIndex) const;
+
+    /// Read a spilled line back from disk
+    QString spilledLine(int row) const;
+
+    QList<QStringList> m_ring;   // fixed capacity, indexed from m_head
+    int m_head = 0;              // ring slot of the oldest in-memory chunk
+    int m_chunkCount = 0;        // in-memory chunks in use
+
+    QStringList m_pending;
+    QTimer m_flushTimer;
+
+    bool m_spillToDisk = false;
+    QTemporaryFile *m_spillFile = nullptr;
+    QList<qint64> m_spillOffsets;     // start offset of each spilled chunk
+    int m_spilledLines = 0;
+
+    // Last spilled chunk read back, so scrolling through it stays cheap
+    mutable int m_cachedSpillChunk = -1;
+    mutable QStringList m_cachedSpillLines;
+};
+
+#endif // OPERATIONLOGMODEL_H
@@ -0,0 +1,54 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "operationlogview.h"
+#include "operationlogmodel.h"
+
+#include <QFontDatabase>
+#include <QScrollBar>
+
+OperationLogView::OperationLogView(QWidget *parent)
+    : QListView(parent)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setUniformItemSizes(true);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setTextElideMode(Qt::ElideNone);
+    setWordWrap(false);
+}
+
+void OperationLogView::setLogModel(OperationLogModel *model)
+{
+    if (QAbstractItemModel *old = this->model())
+        disconnect(old, nullptr, this, nullptr);
+
+    setModel(model);
+    if (!model)
+        return;
+
+    connect(model, &QAbstractItemModel::rowsAboutToBeInserted,
+            this, &OperationLogView::onRowsAboutToBeInserted);
+    connect(model, &QAbstractItemModel::rowsInserted,
+            this, &OperationLogView::onRowsInserted);
+}
+
+void OperationLogView::onRowsAboutToBeInserted()
+{
+    const QScrollBar *bar = verticalScrollBar();
+    m_followTail = bar->value() >= bar->maximum();
+}
+
+void OperationLogView::onRowsInserted()
+{
+    if (m_followTail)
+        scrollToBottom();
+}
@@ -0,0 +1,38 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef OPERATIONLOGVIEW_H
+#define OPERATIONLOGVIEW_H
+
+#include <QListView>
+
+class OperationLogModel;
+
+/// Read-only, virtualized viewer for an OperationLogModel.
+///
+/// Uses uniform item sizes so only the visible rows are laid out and painted,
+/// and follows new output while the view is scrolled to the bottom.
+class OperationLogView : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit OperationLogView(QWidget *parent = nullptr);
+
+    void setLogModel(OperationLogModel *model);
+
+private:
+    void onRowsAboutToBeInserted();
+    void onRowsInserted();
+
+    bool m_followTail = true;
+};
+
+#endif // OPERATIONLOGVIEW_H
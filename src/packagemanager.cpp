@@ -9,14 +9,201 @@
  */
 
 #include "packagemanager.h"
+#include "aurbuilder.h"
+#include "driverprofile.h"
+#include "hardwaredetector.h"
+#include "helpersession.h"
+#include "mirrorranker.h"
+#include "processexecutor.h"
+#include "systemaccess.h"
+#include "vercmp.h"
 
 #include <QProcess>
 #include <QFileInfo>
-#include <QFile>
-#include <QDir>
+#include <QMap>
+#include <QSet>
+#include <QDateTime>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QSettings>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+
+/// Boot-time baseline written by the helper's early-kms command
+const QString kEarlyKmsBaseline = QStringLiteral("/var/lib/rscn-drivers/early-kms.baseline");
+
+/// Parse the kernel, initrd and userspace parts of a systemd-analyze line:
+/// "Startup finished in 1.5s (firmware) + 2.3s (kernel) + 1min 3.1s (userspace) = ..."
+/// Firmware and loader time are not affected by the initramfs and are left out.
+qint64 parseBootTimeMs(const QString &line)
+{
+    static const QRegularExpression partRe(R"(((?:[0-9.]+(?:h|min|s|ms|us) ?)+)\((kernel|initrd|userspace)\))");
+    static const QRegularExpression unitRe(R"(([0-9.]+)(h|min|s|ms|us))");
+
+    qint64 total = 0;
+    bool found = false;
+    auto parts = partRe.globalMatch(line);
+    while (parts.hasNext()) {
+        const QRegularExpressionMatch part = parts.next();
+        auto units = unitRe.globalMatch(part.captured(1));
+        while (units.hasNext()) {
+            const QRegularExpressionMatch unit = units.next();
+            const double value = unit.captured(1).toDouble();
+            const QString suffix = unit.captured(2);
+            if (suffix == "h")
+                total += qint64(value * 3600000);
+            else if (suffix == "min")
+                total += qint64(value * 60000);
+            else if (suffix == "s")
+                total += qint64(value * 1000);
+            else if (suffix == "ms")
+                total += qint64(value);
+        }
+        found = true;
+    }
+    return found ? total : -1;
+}
+
+/// Split firmware package for each firmware directory (or file name prefix),
+/// following the Arch linux-firmware split
+struct FirmwarePrefix {
+    const char *prefix;
+    const char *package;
+};
+
+constexpr FirmwarePrefix kFirmwarePrefixes[] = {
+    {"amdgpu/", "linux-firmware-amdgpu"},
+    {"radeon/", "linux-firmware-radeon"},
+    {"nvidia/", "linux-firmware-nvidia"},
+    {"i915/", "linux-firmware-intel"},
+    {"xe/", "linux-firmware-intel"},
+    {"intel/", "linux-firmware-intel"},
+    {"iwlwifi-", "linux-firmware-intel"},
+    {"rtl_nic/", "linux-firmware-realtek"},
+    {"rtl_bt/", "linux-firmware-realtek"},
+    {"rtlwifi/", "linux-firmware-realtek"},
+    {"rtw88/", "linux-firmware-realtek"},
+    {"rtw89/", "linux-firmware-realtek"},
+    {"brcm/", "linux-firmware-broadcom"},
+    {"bnx2/", "linux-firmware-broadcom"},
+    {"bnx2x/", "linux-firmware-broadcom"},
+    {"tigon/", "linux-firmware-broadcom"},
+    {"mediatek/", "linux-firmware-mediatek"},
+    {"mt7", "linux-firmware-mediatek"},
+    {"ath9k_htc/", "linux-firmware-atheros"},
+    {"ath10k/", "linux-firmware-atheros"},
+    {"ath11k/", "linux-firmware-atheros"},
+    {"ath12k/", "linux-firmware-atheros"},
+    {"ar3k/", "linux-firmware-atheros"},
+    {"qca/", "linux-firmware-atheros"},
+    {"qcom/", "linux-firmware-qcom"},
+    {"mellanox/", "linux-firmware-mellanox"},
+    {"cirrus/", "linux-firmware-cirrus"},
+};
+
+/// nvidia/<driver version>/gsp_*.bin is shipped by nvidia-utils, which the
+/// proprietary profiles already require
+bool shippedWithDriver(const QString &file)
+{
+    return file.startsWith("nvidia/") && file.size() > 7 && file.at(7).isDigit();
+}
+
+/// Split package for a firmware path by its location
+QString firmwarePackageFor(const QString &file)
+{
+    for (const FirmwarePrefix &entry : kFirmwarePrefixes) {
+        if (file.startsWith(QLatin1String(entry.prefix)))
+            return QString::fromLatin1(entry.package);
+    }
+    // Anything else lands in the catch-all package
+    return QStringLiteral("linux-firmware-other");
+}
+
+/// Value of a field in `pacman -Qi`/`-Si` output, with continuation lines
+/// joined: "Provides        : libgl  opengl-driver  nvidia-libgl=550.78".
+/// Only the first block counts if several repos carry the package.
+QString infoField(const QString &output, const QString &field)
+{
+    QString value;
+    bool inField = false;
+    for (const QString &line : output.split('\n')) {
+        if (line.isEmpty())
+            break;
+        if (inField && line.front().isSpace()) {
+            value += ' ' + line.trimmed();
+            continue;
+        }
+        inField = false;
+        const int colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed() == field) {
+            value = line.mid(colon + 1).trimmed();
+            inField = true;
+        }
+    }
+    return value;
+}
+
+/// Kernels offered as alternatives when a driver does not fit the
+/// installed ones, most conservative first
+const QStringList kCandidateKernels = {"linux-lts", "linux", "linux-zen", "linux-hardened"};
+
+/// "6.12.4.arch1-1" -> "6.12"
+QString kernelSeries(const QString &version)
+{
+    static const QRegularExpression series(R"(^(?:\d+:)?(\d+\.\d+))");
+    const QRegularExpressionMatch match = series.match(version);
+    return match.hasMatch() ? match.captured(1) : QString();
+}
+
+/// The requirement a kernel version breaks, in pacman's dependency syntax
+/// ("linux<=6.12.x", "linux-headers<6.13"), or empty if the driver can be
+/// used with it
+QString kernelMismatch(const std::optional<KernelCompatibility> &range,
+                       const QStringList &depends,
+                       const QString &kernel, const QString &version)
+{
+    if (range) {
+        const QString series = kernelSeries(version);
+        if (!range->minKernel.isEmpty() && vercmp(series, range->minKernel) < 0)
+            return QString("%1>=%2").arg(kernel, range->minKernel);
+        if (!range->maxKernel.isEmpty() && vercmp(series, range->maxKernel) > 0)
+            return QString("%1<=%2.x").arg(kernel, range->maxKernel);
+    }
+
+    static const QRegularExpression constraint(R"(^([^<>=]+)(<=|>=|<|>|=)(.+)$)");
+    for (const QString &dep : depends) {
+        const QRegularExpressionMatch match = constraint.match(dep);
+        if (!match.hasMatch())
+            continue;
+        const QString name = match.captured(1);
+        if (name != kernel && name != kernel + "-headers")
+            continue;
+
+        const QString op = match.captured(2);
+        const int cmp = vercmp(version, match.captured(3));
+        const bool satisfied = (op == "<" && cmp < 0) || (op == "<=" && cmp <= 0)
+                            || (op == ">" && cmp > 0) || (op == ">=" && cmp >= 0)
+                            || (op == "=" && cmp == 0);
+        if (!satisfied)
+            return dep;
+    }
+    return {};
+}
+
+/// Arguments as keyed in a system-access bundle: the helper is recorded by
+/// name, so fixtures replay regardless of where it is installed
+QStringList bundleArguments(const QString &program, QStringList args)
+{
+    if (program == "pkexec" && !args.isEmpty())
+        args[0] = QFileInfo(args.at(0)).fileName();
+    return args;
+}
+
+} // namespace
 
 // =============================================================================
 // Construction / Destruction
@@ -24,7 +211,16 @@
 
 PackageManager::PackageManager(QObject *parent)
     : QObject(parent)
+    , m_aurBuilder(new AurBuilder(this))
 {
+    connect(m_aurBuilder, &AurBuilder::output,
+            this, &PackageManager::onAurBuilderOutput);
+    connect(m_aurBuilder, &AurBuilder::packageBuilt,
+            this, &PackageManager::aurPackageBuilt);
+    connect(m_aurBuilder, &AurBuilder::privilegedCommandRequested,
+            this, &PackageManager::onAurPrivilegedCommand);
+    connect(m_aurBuilder, &AurBuilder::finished,
+            this, &PackageManager::finishOperation);
 }
 
 PackageManager::~PackageManager()
@@ -43,11 +239,8 @@ PackageManager::~PackageManager()
 
 QPair<QString, int> PackageManager::runCommand(const QString &command, const QStringList &args) const
 {
-    QProcess process;
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start(command, args);
-    process.waitForFinished(10000);
-    return {process.readAllStandardOutput(), process.exitCode()};
+    const CommandResult result = SystemAccess::instance().run(command, args, 10000);
+    return {QString::fromUtf8(result.output), result.exitCode};
 }
 
 // =============================================================================
@@ -87,51 +280,167 @@ QString PackageManager::availableVersion(const QString &packageName)
     if (exitCode != 0)
         return {};
 
-    // Parse "Version         : x.y.z-r"
-    for (const QString &line : output.split('\n')) {
-        QString trimmed = line.trimmed();
-        if (trimmed.startsWith("Version")) {
-            int colonPos = trimmed.indexOf(':');
-            if (colonPos >= 0)
-                return trimmed.mid(colonPos + 1).trimmed();
-        }
+    return infoField(output, "Version");
+}
+
+QList<bool> PackageManager::queryInstalled(const QStringList &packages) const
+{
+    if (packages.isEmpty())
+        return {};
+
+    // One multi-target `pacman -Q`: it prints "<name> <version>" for every
+    // installed target and an error line for each missing one, exiting 1
+    // if any is missing, so the listed names are what counts
+    const CommandResult result = SystemAccess::instance().run("pacman", QStringList() << "-Q" << packages);
+
+    QSet<QString> found;
+    for (const QString &line : QString::fromUtf8(result.output).split('\n', Qt::SkipEmptyParts)) {
+        if (line.startsWith("error:"))
+            continue;
+        found.insert(line.section(' ', 0, 0));
     }
-    return {};
+
+    QList<bool> installed;
+    installed.reserve(packages.size());
+    for (const QString &pkg : packages)
+        installed.append(found.contains(pkg));
+    return installed;
 }
 
 QStringList PackageManager::filterInstalled(const QStringList &packages)
 {
+    const QList<bool> flags = queryInstalled(packages);
     QStringList installed;
-    for (const QString &pkg : packages) {
-        if (isPackageInstalled(pkg))
-            installed.append(pkg);
+    for (qsizetype i = 0; i < packages.size(); ++i) {
+        if (flags.at(i))
+            installed.append(packages.at(i));
     }
     return installed;
 }
 
 QStringList PackageManager::filterNotInstalled(const QStringList &packages)
 {
+    const QList<bool> flags = queryInstalled(packages);
     QStringList notInstalled;
-    for (const QString &pkg : packages) {
-        if (!isPackageInstalled(pkg))
-            notInstalled.append(pkg);
+    for (qsizetype i = 0; i < packages.size(); ++i) {
+        if (!flags.at(i))
+            notInstalled.append(packages.at(i));
     }
     return notInstalled;
 }
 
+QStringList PackageManager::unsatisfiedDependencies(const QStringList &deps)
+{
+    if (deps.isEmpty())
+        return {};
+
+    auto [output, exitCode] = runCommand("pacman", QStringList() << "-T" << deps);
+    Q_UNUSED(exitCode);  // 127 when anything is missing
+    return output.split('\n', Qt::SkipEmptyParts);
+}
+
+QStringList PackageManager::packageRelations(const QString &packageName, const QString &field, bool local)
+{
+    auto [output, exitCode] = runCommand("pacman", {local ? "-Qi" : "-Si", packageName});
+    if (exitCode != 0)
+        return {};
+
+    static const QRegularExpression constraint(R"([<>=].*$)");
+    QStringList names;
+    for (QString name : infoField(output, field).split(' ', Qt::SkipEmptyParts)) {
+        if (name == "None")
+            continue;
+        names.append(name.remove(constraint));
+    }
+    return names;
+}
+
+QList<SyncPackage> PackageManager::searchRepositories(const QString &query, int limit)
+{
+    return m_syncIndex.search(query, limit);
+}
+
+KernelPreflight PackageManager::checkKernelCompatibility(const QStringList &packages)
+{
+    KernelPreflight result;
+    const QStringList kernels = HardwareDetector::installedKernels();
+    if (packages.isEmpty() || kernels.isEmpty())
+        return result;
+
+    QMap<QString, QString> kernelVersions;
+    for (const QString &kernel : kernels) {
+        const QString version = installedVersion(kernel);
+        if (!version.isEmpty())
+            kernelVersions.insert(kernel, version);
+    }
+
+    // One concurrent batch for the depends of every package; AUR packages
+    // are not in the sync DBs and are covered by the table alone
+    QList<CommandSpec> specs;
+    for (const QString &pkg : packages)
+        specs.append({"pacman", {"-Si", pkg}});
+    const QList<CommandResult> infos = ProcessExecutor::instance().runAll(specs);
+
+    QStringList errors;
+    for (qsizetype i = 0; i < packages.size(); ++i) {
+        const QString &pkg = packages.at(i);
+        const std::optional<KernelCompatibility> range = DriverProfileManager::kernelCompatibility(pkg);
+        const QStringList depends = infos.at(i).exitCode == 0
+            ? infoField(QString::fromUtf8(infos.at(i).output), "Depends On").split(' ', Qt::SkipEmptyParts)
+            : QStringList();
+
+        bool blocked = false;
+        for (auto it = kernelVersions.cbegin(); it != kernelVersions.cend(); ++it) {
+            const QString mismatch = kernelMismatch(range, depends, it.key(), it.value());
+            if (mismatch.isEmpty())
+                continue;
+            errors.append(tr("%1 cannot be used with %2 %3 (requires %4)")
+                              .arg(pkg, it.key(), it.value(), mismatch));
+            blocked = true;
+        }
+        if (!blocked)
+            continue;
+
+        // Only reached on failure, so the repo lookups cost nothing normally
+        for (const QString &kernel : kCandidateKernels) {
+            const bool installed = kernelVersions.contains(kernel);
+            const QString version = installed ? kernelVersions.value(kernel) : availableVersion(kernel);
+            if (version.isEmpty() || !kernelMismatch(range, depends, kernel, version).isEmpty())
+                continue;
+            result.suggestions.append(installed
+                ? tr("%1 with the installed %2 %3, removing the other kernels").arg(pkg, kernel, version)
+                : tr("%1 with %2 %3 from the repositories").arg(pkg, kernel, version));
+        }
+    }
+
+    if (errors.isEmpty())
+        return result;
+
+    result.error = errors.join('\n');
+    if (result.suggestions.isEmpty())
+        result.error += '\n' + tr("No packaged kernel is supported by this driver.");
+    else
+        result.error += '\n' + tr("This would work instead:") + "\n  " + result.suggestions.join("\n  ");
+    return result;
+}
+
 QString PackageManager::findAurHelper()
 {
     if (m_aurHelperDetected)
         return m_cachedAurHelper;
 
-    // Check common AUR helpers in order of preference
-    for (const QString &helper : {"paru", "yay", "pikaur", "trizen"}) {
-        auto [output, exitCode] = runCommand("which", {helper});
-        Q_UNUSED(output);
-        if (exitCode == 0) {
-            m_cachedAurHelper = helper;
+    // Probe all common AUR helpers at once, then pick by preference
+    const QStringList helpers = {"paru", "yay", "pikaur", "trizen"};
+    QList<CommandSpec> specs;
+    for (const QString &helper : helpers)
+        specs.append({"which", {helper}, 10000});
+
+    const QList<CommandResult> results = ProcessExecutor::instance().runAll(specs);
+    for (qsizetype i = 0; i < helpers.size(); ++i) {
+        if (results.at(i).exitCode == 0) {
+            m_cachedAurHelper = helpers.at(i);
             m_aurHelperDetected = true;
-            return helper;
+            return m_cachedAurHelper;
         }
     }
 
@@ -152,32 +461,31 @@ bool PackageManager::isAurPackageInstalled(const QString &packageName)
 
 bool PackageManager::isPacmanLocked() const
 {
-    return QFileInfo::exists("/var/lib/pacman/db.lck");
+    return SystemAccess::instance().exists("/var/lib/pacman/db.lck");
 }
 
 bool PackageManager::isNetworkAvailable() const
 {
     // Check if a default route exists (simple and dependency-free)
-    QProcess process;
-    process.start("ip", {"route", "show", "default"});
-    process.waitForFinished(5000);
-    QString output = process.readAllStandardOutput().trimmed();
-    return !output.isEmpty();
+    const CommandResult result = SystemAccess::instance().run("ip", {"route", "show", "default"}, 5000);
+    return result.exitCode == 0 && !result.output.trimmed().isEmpty();
 }
 
 bool PackageManager::isOperationRunning() const
 {
+    if (m_aurBuilder->isRunning() || m_replayTimer || m_sessionRequest >= 0 || m_aurSessionRequest >= 0
+        || m_mirrorProbe != 0)
+        return true;
     return m_process != nullptr && m_process->state() != QProcess::NotRunning;
 }
 
 bool PackageManager::isKmsHookPresent() const
 {
-    QFile file("/etc/mkinitcpio.conf");
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    const std::optional<QByteArray> conf = SystemAccess::instance().readFile("/etc/mkinitcpio.conf");
+    if (!conf)
         return false;
 
-    QString content = file.readAll();
-    file.close();
+    QString content = QString::fromUtf8(*conf);
 
     // Look for 'kms' in HOOKS=(...) line
     QRegularExpression re(R"(^HOOKS=\((.+)\))", QRegularExpression::MultilineOption);
@@ -189,6 +497,154 @@ bool PackageManager::isKmsHookPresent() const
     return false;
 }
 
+qint64 PackageManager::bootTimeMs() const
+{
+    auto result = runCommand("systemd-analyze", {"time"});
+    if (result.second != 0)
+        return -1;
+    return parseBootTimeMs(result.first.section('\n', 0, 0));
+}
+
+std::optional<qint64> PackageManager::earlyKmsBootDeltaMs() const
+{
+    SystemAccess &system = SystemAccess::instance();
+    const std::optional<QByteArray> baseline = system.readFile(kEarlyKmsBaseline);
+    if (!baseline)
+        return std::nullopt;
+
+    QString baselineBootId;
+    qint64 baselineMs = -1;
+    for (const QString &rawLine : QString::fromUtf8(*baseline).split('\n')) {
+        const QString line = rawLine.trimmed();
+        if (line.startsWith("boot_id="))
+            baselineBootId = line.mid(8);
+        else if (line.startsWith("time="))
+            baselineMs = parseBootTimeMs(line.mid(5));
+    }
+
+    // Still the boot the baseline was taken in: nothing to compare yet
+    const std::optional<QByteArray> bootIdFile = system.readFile("/proc/sys/kernel/random/boot_id");
+    if (!bootIdFile)
+        return std::nullopt;
+    const QString bootId = QString::fromUtf8(*bootIdFile).trimmed();
+    if (baselineMs < 0 || bootId == baselineBootId)
+        return std::nullopt;
+
+    const qint64 currentMs = bootTimeMs();
+    if (currentMs < 0)
+        return std::nullopt;
+    return currentMs - baselineMs;
+}
+
+QStringList PackageManager::currentKernelParameters() const
+{
+    const std::optional<QByteArray> cmdline = SystemAccess::instance().readFile("/proc/cmdline");
+    if (!cmdline)
+        return {};
+    return QString::fromUtf8(*cmdline).simplified().split(' ', Qt::SkipEmptyParts);
+}
+
+QString PackageManager::fileOwner(const QString &path)
+{
+    return m_ownershipIndex.ownerOf(path);
+}
+
+QString PackageManager::kernelModuleOwner(const QString &module)
+{
+    // Only loaded modules are of interest
+    const QString sysModule = "/sys/module/" + module;
+    if (!SystemAccess::instance().exists(sysModule))
+        return {};
+
+    auto [path, exitCode] = runCommand("modinfo", {"-n", module});
+    path = path.trimmed();
+    if (exitCode != 0 || path.isEmpty())
+        return {};
+
+    QString owner = m_ownershipIndex.ownerOf(path);
+    if (!owner.isEmpty())
+        return owner;
+
+    // DKMS installs its build output (updates/dkms/*.ko) without a package
+    // owner. The source tree it was built from is owned, though:
+    // /usr/src/<module>-<version>/dkms.conf
+    QString version;
+    if (const auto versionFile = SystemAccess::instance().readFile(sysModule + "/version"))
+        version = QString::fromUtf8(*versionFile).trimmed();
+    if (version.isEmpty()) {
+        auto [modVersion, versionExit] = runCommand("modinfo", {"-F", "version", module});
+        if (versionExit == 0)
+            version = modVersion.trimmed();
+    }
+    if (version.isEmpty())
+        return {};
+
+    return m_ownershipIndex.ownerOf("/usr/src/" + module + "-" + version + "/dkms.conf");
+}
+
+QStringList PackageManager::moduleFirmware(const QString &module)
+{
+    const auto cached = m_moduleFirmware.constFind(module);
+    if (cached != m_moduleFirmware.constEnd())
+        return cached.value();
+
+    // modinfo reads the .modinfo section of the module file, whether or not
+    // it is loaded
+    QStringList files;
+    auto [output, exitCode] = runCommand("modinfo", {"-F", "firmware", module});
+    if (exitCode == 0) {
+        for (const QString &line : output.split('\n', Qt::SkipEmptyParts)) {
+            const QString file = line.trimmed();
+            if (!file.isEmpty() && !files.contains(file))
+                files.append(file);
+        }
+    }
+
+    m_moduleFirmware.insert(module, files);
+    return files;
+}
+
+QStringList PackageManager::firmwarePackages(const QStringList &firmwareFiles)
+{
+    QStringList packages;
+    for (const QString &file : firmwareFiles) {
+        if (shippedWithDriver(file))
+            continue;
+
+        // Installed firmware is compressed; the owner is authoritative
+        QString owner;
+        for (const char *suffix : {".zst", ".xz", ""}) {
+            owner = m_ownershipIndex.ownerOf("/usr/lib/firmware/" + file + QLatin1String(suffix));
+            if (!owner.isEmpty())
+                break;
+        }
+        // Still the pre-split monolithic package: fall back to the table
+        if (owner == "linux-firmware")
+            owner.clear();
+        if (owner.isEmpty())
+            owner = firmwarePackageFor(file);
+        if (!packages.contains(owner))
+            packages.append(owner);
+    }
+
+    // Table guesses only count if the repos actually carry the split
+    // packages; the answer cannot change within a session
+    QStringList available;
+    for (const QString &pkg : std::as_const(packages)) {
+        auto it = m_firmwarePackageAvailable.find(pkg);
+        if (it == m_firmwarePackageAvailable.end())
+            it = m_firmwarePackageAvailable.insert(pkg, isPackageInstalled(pkg) || isPackageAvailable(pkg));
+        if (it.value())
+            available.append(pkg);
+    }
+    return available;
+}
+
+bool PackageManager::isDkmsPackage(const QString &packageName)
+{
+    return packageName.endsWith("-dkms");
+}
+
 QString PackageManager::pkHelperPath()
 {
     // 1. Check environment variable (for development/testing)
@@ -211,6 +667,40 @@ QString PackageManager::pkHelperPath()
     return "/usr/lib/rscn-drivers/rscn-drivers-pkhelper";
 }
 
+QString PackageManager::operationName(OperationType type)
+{
+    switch (type) {
+    case OperationType::None:                 return "none";
+    case OperationType::PacmanInstall:        return "pacman_install";
+    case OperationType::PacmanRemove:         return "pacman_remove";
+    case OperationType::AurInstall:           return "aur_install";
+    case OperationType::AurRemove:            return "aur_remove";
+    case OperationType::RemoveKmsHook:        return "remove_kms_hook";
+    case OperationType::RegenerateInitramfs:  return "regenerate_initramfs";
+    case OperationType::RegenerateGrubConfig: return "regenerate_grub_config";
+    case OperationType::Rollback:             return "rollback";
+    case OperationType::DkmsBuild:            return "dkms_build";
+    case OperationType::ConfigureEarlyKms:    return "configure_early_kms";
+    case OperationType::ConfigureRuntimePm:   return "configure_runtime_pm";
+    case OperationType::ProfileSwitch:        return "profile_switch";
+    case OperationType::KernelParameters:     return "kernel_parameters";
+    }
+    return "unknown";
+}
+
+QString PackageManager::snapshotDirectory()
+{
+    return "/var/lib/rscn-drivers/snapshots";
+}
+
+QStringList PackageManager::availableSnapshots() const
+{
+    // Snapshot ids start with a sortable timestamp
+    QStringList ids = SystemAccess::instance().entryList(snapshotDirectory());
+    std::reverse(ids.begin(), ids.end());
+    return ids;
+}
+
 // =============================================================================
 // Async process management
 // =============================================================================
@@ -226,6 +716,8 @@ void PackageManager::setupProcess()
     m_process = new QProcess(this);
     m_process->setProcessChannelMode(QProcess::MergedChannels);
 
+    connect(m_process, &QProcess::started,
+            this, &PackageManager::onProcessStarted);
     connect(m_process, &QProcess::readyRead,
             this, &PackageManager::onProcessReadyRead);
     connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
@@ -243,6 +735,49 @@ void PackageManager::cleanupProcess()
     m_currentOperation = OperationType::None;
 }
 
+void PackageManager::finishOperation(bool success, const QString &errorMessage)
+{
+    const OperationType type = m_currentOperation;
+    const qint64 elapsed = m_operationTimer.isValid() ? m_operationTimer.elapsed() : 0;
+    m_operationTimer.invalidate();
+
+    // Capture the run as a fixture when recording a system-access bundle
+    if (type != OperationType::None && !m_record.program.isEmpty()) {
+        CommandResult result;
+        result.output = m_record.output;
+        result.exitCode = m_record.exitCode;
+        result.durationMs = elapsed;
+        SystemAccess::instance().recordCommand(
+            m_record.program, bundleArguments(m_record.program, m_record.arguments), result);
+    }
+
+    // Persist the complete run for post-mortem analysis
+    if (type != OperationType::None) {
+        m_record.finished = QDateTime::currentDateTime();
+        m_record.success = success;
+        // The AUR build pipeline has no single exit code; the index only
+        // keeps the exit code, so a success is recorded as 0
+        if (success && m_record.exitCode < 0)
+            m_record.exitCode = 0;
+        m_record.errorMessage = errorMessage;
+        if (!m_journal.append(m_record))
+            qWarning() << "Failed to write operation journal entry";
+    }
+    m_record = OperationRecord();
+
+    cleanupProcess();
+    emit operationFinished(success, errorMessage);
+}
+
+void PackageManager::beginRecord(OperationType type, const QString &program, const QStringList &args)
+{
+    m_record = OperationRecord();
+    m_record.type = type;
+    m_record.program = program;
+    m_record.arguments = args;
+    m_record.requested = QDateTime::currentDateTime();
+}
+
 void PackageManager::startPrivilegedOperation(const QStringList &helperArgs, OperationType type)
 {
     if (isOperationRunning()) {
@@ -251,19 +786,47 @@ void PackageManager::startPrivilegedOperation(const QStringList &helperArgs, Ope
     }
 
     QString helper = pkHelperPath();
+    if (SystemAccess::instance().mode() == SystemAccess::Mode::Replay) {
+        replayOperation("pkexec", QStringList() << helper << helperArgs, type);
+        return;
+    }
     if (!QFileInfo::exists(helper)) {
         emit operationFinished(false,
             tr("Privileged helper script not found at: %1").arg(helper));
         return;
     }
 
+    const QStringList args = QStringList() << helper << helperArgs;
+
+    // Already authorized: hand the command to the running helper. Commands
+    // the session does not serve (rollback) still get their own pkexec.
+    if (hasPrivilegedSession() && HelperSession::acceptsCommand(helperArgs.value(0))) {
+        const int id = m_session->submit(helperArgs);
+        if (id < 0) {
+            emit operationFinished(false, tr("Invalid arguments for the privileged helper"));
+            return;
+        }
+        qDebug() << "Running in privileged session:" << helperArgs;
+        m_currentOperation = type;
+        m_sessionRequest = id;
+        // Recorded like a one-shot run, so journals and fixtures match
+        beginRecord(type, "pkexec", args);
+        m_record.started = m_record.requested;
+        m_operationTimer.start();
+        emit operationStarted(type);
+        return;
+    }
+
     m_currentOperation = type;
     setupProcess();
 
     qDebug() << "Starting privileged operation: pkexec" << helper << helperArgs;
 
+    beginRecord(type, "pkexec", args);
+
+    m_operationTimer.start();
     emit operationStarted(type);
-    m_process->start("pkexec", QStringList() << helper << helperArgs);
+    m_process->start("pkexec", args);
 }
 
 void PackageManager::startUserOperation(const QString &command, const QStringList &args, OperationType type)
@@ -273,24 +836,67 @@ void PackageManager::startUserOperation(const QString &command, const QStringLis
         return;
     }
 
+    if (SystemAccess::instance().mode() == SystemAccess::Mode::Replay) {
+        replayOperation(command, args, type);
+        return;
+    }
+
     m_currentOperation = type;
     setupProcess();
 
     qDebug() << "Starting user operation:" << command << args;
 
+    beginRecord(type, command, args);
+
+    m_operationTimer.start();
     emit operationStarted(type);
     m_process->start(command, args);
 }
 
-void PackageManager::onProcessReadyRead()
+void PackageManager::replayOperation(const QString &program, const QStringList &args, OperationType type)
 {
-    if (!m_process)
-        return;
+    SystemAccess &system = SystemAccess::instance();
+
+    m_currentOperation = type;
+    beginRecord(type, program, args);
+    m_record.started = m_record.requested;
+
+    qDebug() << "Replaying operation:" << program << args;
 
-    QByteArray data = m_process->readAll();
+    m_operationTimer.start();
+    emit operationStarted(type);
+
+    const std::optional<CommandResult> result = system.recordedCommand(program, bundleArguments(program, args));
+    const qint64 delay = result ? system.replayLatencyMs(*result) : 0;
+
+    m_replayTimer = new QTimer(this);
+    m_replayTimer->setSingleShot(true);
+    connect(m_replayTimer, &QTimer::timeout, this, [this, result]() {
+        m_replayTimer->deleteLater();
+        m_replayTimer = nullptr;
+
+        if (!result) {
+            finishOperation(false, tr("No recorded result for this operation in the replay bundle"));
+            return;
+        }
+        appendOutput(result->output);
+        if (result->exitCode < 0)
+            onProcessFinished(0, QProcess::CrashExit);
+        else
+            onProcessFinished(result->exitCode, QProcess::NormalExit);
+    });
+    m_replayTimer->start(int(delay));
+}
+
+void PackageManager::appendOutput(const QByteArray &data)
+{
     if (data.isEmpty())
         return;
 
+    if (!m_record.firstOutput.isValid())
+        m_record.firstOutput = QDateTime::currentDateTime();
+    m_record.output.append(data);
+
     QString text = QString::fromUtf8(data);
     const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
     for (const QString &line : lines) {
@@ -301,25 +907,30 @@ void PackageManager::onProcessReadyRead()
     }
 }
 
+void PackageManager::onProcessStarted()
+{
+    m_record.started = QDateTime::currentDateTime();
+}
+
+void PackageManager::onProcessReadyRead()
+{
+    if (!m_process)
+        return;
+
+    appendOutput(m_process->readAll());
+}
+
 void PackageManager::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     // Read any remaining buffered output
-    if (m_process) {
-        QByteArray remaining = m_process->readAll();
-        if (!remaining.isEmpty()) {
-            QString text = QString::fromUtf8(remaining);
-            const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
-            for (const QString &line : lines) {
-                QString trimmed = line.trimmed();
-                if (!trimmed.isEmpty())
-                    emit operationOutput(trimmed);
-            }
-        }
-    }
+    if (m_process)
+        appendOutput(m_process->readAll());
 
     bool success = (exitCode == 0 && exitStatus == QProcess::NormalExit);
     QString errorMsg;
 
+    m_record.exitCode = (exitStatus == QProcess::NormalExit) ? exitCode : -1;
+
     if (exitStatus == QProcess::CrashExit) {
         errorMsg = tr("Operation crashed unexpectedly");
     } else if (exitCode == 126) {
@@ -332,8 +943,7 @@ void PackageManager::onProcessFinished(int exitCode, QProcess::ExitStatus exitSt
         errorMsg = tr("Operation failed with exit code %1").arg(exitCode);
     }
 
-    cleanupProcess();
-    emit operationFinished(success, errorMsg);
+    finishOperation(success, errorMsg);
 }
 
 void PackageManager::onProcessError(QProcess::ProcessError error)
@@ -362,8 +972,7 @@ void PackageManager::onProcessError(QProcess::ProcessError error)
         break;
     }
 
-    cleanupProcess();
-    emit operationFinished(false, errorMsg);
+    finishOperation(false, errorMsg);
 }
 
 // =============================================================================
@@ -377,12 +986,25 @@ void PackageManager::installPackages(const QStringList &packages)
         return;
     }
 
+    // Before the preflight, whose pacman queries would be wasted
+    if (isOperationRunning()) {
+        emit operationFinished(false, tr("Another operation is already running"));
+        return;
+    }
+
     if (isPacmanLocked()) {
         emit operationFinished(false,
             tr("Pacman database is locked. Is another package manager running?"));
         return;
     }
 
+    // Fail before the download and DKMS build rather than after
+    const KernelPreflight preflight = checkKernelCompatibility(packages);
+    if (!preflight.ok()) {
+        emit operationFinished(false, preflight.error);
+        return;
+    }
+
     if (!isNetworkAvailable()) {
         emit operationFinished(false,
             tr("No network connectivity detected. "
@@ -390,9 +1012,102 @@ void PackageManager::installPackages(const QStringList &packages)
         return;
     }
 
+    // Let the helper register the DKMS modules and build them for all
+    // kernels concurrently, instead of the dkms pacman hook's
+    // one-kernel-at-a-time loop
+    QStringList args;
+    args << "install";
+    if (std::any_of(packages.cbegin(), packages.cend(), &PackageManager::isDkmsPackage))
+        args << "--defer-dkms";
+    startRankedTransaction(args, packages, OperationType::PacmanInstall);
+}
+
+QStringList PackageManager::mirrorArguments(const QList<MirrorProbe> &probes)
+{
+    const QStringList ranked = MirrorRanker::rankedServers(probes);
+    if (ranked.isEmpty()) {
+        qDebug() << "No mirror answered the probe; using the system mirrorlist as is";
+        return {};
+    }
+
+    const int parallel = MirrorRanker::recommendedParallelDownloads(probes);
+    qDebug() << "Fastest mirror:" << ranked.first() << "ParallelDownloads:" << parallel;
+
+    // The helper only accepts servers from the system mirrorlist, so a
+    // stand-in list is probed but not used
+    if (MirrorRanker::isMirrorlistOverridden())
+        return {"--parallel-downloads", QString::number(parallel)};
+    return {"--mirrors", ranked.join(','),
+            "--parallel-downloads", QString::number(parallel)};
+}
+
+void PackageManager::startRankedTransaction(const QStringList &helperArgs, const QStringList &packages,
+                                            OperationType type)
+{
+    if (isOperationRunning()) {
+        emit operationFinished(false, tr("Another operation is already running"));
+        return;
+    }
+
+    if (!QSettings().value("mirrors/rankBeforeInstall", true).toBool()) {
+        startPrivilegedOperation(helperArgs + packages, type);
+        return;
+    }
+
+    // The probes take up to their timeout; wait for them off the GUI thread
+    const int probe = ++m_lastMirrorProbe;
+    m_mirrorProbe = probe;
+    MirrorRanker().probeAsync().then(this, [this, probe, helperArgs, packages, type](
+                                               const QList<MirrorProbe> &probes) {
+        if (m_mirrorProbe != probe)
+            return; // canceled
+        m_mirrorProbe = 0;
+        startPrivilegedOperation(helperArgs + mirrorArguments(probes) + packages, type);
+    });
+}
+
+void PackageManager::switchPackages(const QStringList &install, const QStringList &remove)
+{
+    if (install.isEmpty() && remove.isEmpty()) {
+        emit operationFinished(true, {});
+        return;
+    }
+
+    if (isOperationRunning()) {
+        emit operationFinished(false, tr("Another operation is already running"));
+        return;
+    }
+
+    if (isPacmanLocked()) {
+        emit operationFinished(false,
+            tr("Pacman database is locked. Is another package manager running?"));
+        return;
+    }
+
+    const KernelPreflight preflight = checkKernelCompatibility(install);
+    if (!preflight.ok()) {
+        emit operationFinished(false, preflight.error);
+        return;
+    }
+
+    if (!install.isEmpty() && !isNetworkAvailable()) {
+        emit operationFinished(false,
+            tr("No network connectivity detected. "
+               "A working internet connection is required to install packages."));
+        return;
+    }
+
     QStringList args;
-    args << "install" << packages;
-    startPrivilegedOperation(args, OperationType::PacmanInstall);
+    args << "switch";
+    if (!remove.isEmpty())
+        args << "--remove" << remove.join(',');
+    if (std::any_of(install.cbegin(), install.cend(), &PackageManager::isDkmsPackage))
+        args << "--defer-dkms";
+    if (install.isEmpty()) {
+        startPrivilegedOperation(args, OperationType::ProfileSwitch);
+        return;
+    }
+    startRankedTransaction(args, install, OperationType::ProfileSwitch);
 }
 
 void PackageManager::removePackages(const QStringList &packages)
@@ -420,6 +1135,11 @@ void PackageManager::installAurPackages(const QStringList &packages)
         return;
     }
 
+    if (isOperationRunning()) {
+        emit operationFinished(false, tr("Another operation is already running"));
+        return;
+    }
+
     QString aurHelper = findAurHelper();
     if (aurHelper.isEmpty()) {
         emit operationFinished(false,
@@ -434,6 +1154,12 @@ void PackageManager::installAurPackages(const QStringList &packages)
         return;
     }
 
+    const KernelPreflight preflight = checkKernelCompatibility(packages);
+    if (!preflight.ok()) {
+        emit operationFinished(false, preflight.error);
+        return;
+    }
+
     if (!isNetworkAvailable()) {
         emit operationFinished(false,
             tr("No network connectivity detected. "
@@ -441,11 +1167,99 @@ void PackageManager::installAurPackages(const QStringList &packages)
         return;
     }
 
-    // AUR helpers must run as the current user (not as root).
-    // They handle privilege escalation internally via sudo when needed.
-    QStringList args;
-    args << "-S" << "--noconfirm" << "--needed" << packages;
-    startUserOperation(aurHelper, args, OperationType::AurInstall);
+    // Builds run as the current user (not as root); only installing the
+    // results goes through the privileged helper. The builder goes through
+    // SystemAccess itself, so a replay runs it too.
+    m_currentOperation = OperationType::AurInstall;
+    beginRecord(OperationType::AurInstall, aurHelper, packages);
+    m_record.started = m_record.requested;
+
+    m_operationTimer.start();
+    emit operationStarted(OperationType::AurInstall);
+
+    m_aurBuilder->setAurHelper(aurHelper);
+    m_aurBuilder->start(packages);
+}
+
+void PackageManager::onAurBuilderOutput(const QString &line)
+{
+    if (!m_record.firstOutput.isValid())
+        m_record.firstOutput = QDateTime::currentDateTime();
+    m_record.output.append(line.toUtf8()).append('\n');
+    emit operationOutput(line);
+}
+
+void PackageManager::onAurPrivilegedCommand(const QStringList &helperArgs)
+{
+    SystemAccess &system = SystemAccess::instance();
+    const QStringList args = QStringList() << pkHelperPath() << helperArgs;
+    m_aurStepArgs = bundleArguments("pkexec", args);
+    m_aurStepOutputStart = m_record.output.size();
+    m_aurStepElapsed.start();
+
+    if (system.mode() == SystemAccess::Mode::Replay) {
+        const std::optional<CommandResult> result = system.recordedCommand("pkexec", m_aurStepArgs);
+        m_aurStepTimer = new QTimer(this);
+        m_aurStepTimer->setSingleShot(true);
+        connect(m_aurStepTimer, &QTimer::timeout, this, [this, result]() {
+            m_aurStepTimer->deleteLater();
+            m_aurStepTimer = nullptr;
+            if (result)
+                appendOutput(result->output);
+            finishAurStep(result ? result->exitCode : -1);
+        });
+        qDebug() << "Replaying AUR build step:" << helperArgs;
+        m_aurStepTimer->start(int(result ? system.replayLatencyMs(*result) : 0));
+        return;
+    }
+
+    // Dependency and package installs of an AUR build use the open session
+    // like every other privileged step
+    if (hasPrivilegedSession() && HelperSession::acceptsCommand(helperArgs.value(0))) {
+        m_aurSessionRequest = m_session->submit(helperArgs);
+        if (m_aurSessionRequest >= 0) {
+            qDebug() << "Running AUR build step in privileged session:" << helperArgs;
+            return;
+        }
+    }
+
+    auto *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    m_aurStepProcess = process;
+
+    auto done = [this, process](int exitCode) {
+        appendOutput(process->readAll());
+        process->disconnect(this);
+        process->deleteLater();
+        m_aurStepProcess = nullptr;
+        finishAurStep(exitCode);
+    };
+    connect(process, &QProcess::readyRead, this, [this, process]() {
+        appendOutput(process->readAll());
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [done](int exitCode, QProcess::ExitStatus status) {
+                done(status == QProcess::NormalExit ? exitCode : -1);
+            });
+    connect(process, &QProcess::errorOccurred, this, [done](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            done(-1);
+    });
+
+    qDebug() << "Running AUR build step: pkexec" << args;
+    process->start("pkexec", args);
+}
+
+void PackageManager::finishAurStep(int exitCode)
+{
+    // Keyed like a one-shot pkexec run, also when it ran in the session
+    CommandResult result;
+    result.output = m_record.output.mid(m_aurStepOutputStart);
+    result.exitCode = exitCode;
+    result.durationMs = m_aurStepElapsed.elapsed();
+    SystemAccess::instance().recordCommand("pkexec", m_aurStepArgs, result);
+
+    m_aurBuilder->privilegedCommandFinished(exitCode == 0, exitCode);
 }
 
 void PackageManager::removeAurPackages(const QStringList &packages)
@@ -482,18 +1296,211 @@ void PackageManager::regenerateInitramfs()
     startPrivilegedOperation({"regenerate-initramfs"}, OperationType::RegenerateInitramfs);
 }
 
-void PackageManager::regenerateGrubConfig()
+void PackageManager::regenerateGrubConfig(bool force)
+{
+    QStringList args;
+    args << "regenerate-grub";
+    if (force)
+        args << "--force";
+    startPrivilegedOperation(args, OperationType::RegenerateGrubConfig);
+}
+
+void PackageManager::updateKernelParameters(const QStringList &parameters, bool add)
+{
+    if (parameters.isEmpty()) {
+        emit operationFinished(true, {});
+        return;
+    }
+
+    QStringList args;
+    args << "kernel-params" << (add ? "add" : "remove") << parameters;
+    startPrivilegedOperation(args, OperationType::KernelParameters);
+}
+
+void PackageManager::configureEarlyKms(const QStringList &modules)
+{
+    if (modules.isEmpty()) {
+        emit operationFinished(true, {});
+        return;
+    }
+
+    QStringList args;
+    args << "early-kms" << modules;
+    startPrivilegedOperation(args, OperationType::ConfigureEarlyKms);
+}
+
+void PackageManager::disableEarlyKms()
+{
+    startPrivilegedOperation({"early-kms", "--remove"}, OperationType::ConfigureEarlyKms);
+}
+
+void PackageManager::configureRuntimePowerManagement(bool enable, bool withPowerd)
+{
+    QStringList args;
+    args << "runtime-pm" << (enable ? "enable" : "disable");
+    if (enable && withPowerd)
+        args << "--powerd";
+    startPrivilegedOperation(args, OperationType::ConfigureRuntimePm);
+}
+
+void PackageManager::rebuildDkmsModules()
+{
+    startPrivilegedOperation({"dkms-build"}, OperationType::DkmsBuild);
+}
+
+void PackageManager::rollback(const QString &snapshotId)
+{
+    if (isPacmanLocked()) {
+        emit operationFinished(false,
+            tr("Pacman database is locked. Is another package manager running?"));
+        return;
+    }
+
+    // Deliberately no network check: rollback only uses the package cache
+    QStringList args;
+    args << "rollback" << (snapshotId.isEmpty() ? QString("latest") : snapshotId);
+    startPrivilegedOperation(args, OperationType::Rollback);
+}
+
+// =============================================================================
+// Privileged session
+// =============================================================================
+
+bool PackageManager::hasPrivilegedSession() const
+{
+    return m_session && m_session->isOpen();
+}
+
+void PackageManager::openPrivilegedSession()
+{
+    if (m_session)
+        return;
+
+    // Replayed runs are keyed per command; there is nothing to keep open
+    if (SystemAccess::instance().mode() == SystemAccess::Mode::Replay) {
+        emit privilegedSessionChanged(false, {});
+        return;
+    }
+
+    const QString helper = pkHelperPath();
+    if (!QFileInfo::exists(helper)) {
+        emit privilegedSessionChanged(false,
+            tr("Privileged helper script not found at: %1").arg(helper));
+        return;
+    }
+
+    m_session = new HelperSession(helper, this);
+    connect(m_session, &HelperSession::opened, this, [this]() {
+        emit privilegedSessionChanged(true, {});
+    });
+    connect(m_session, &HelperSession::openFailed, this, [this](const QString &error) {
+        m_session->deleteLater();
+        m_session = nullptr;
+        emit privilegedSessionChanged(false, error);
+    });
+    connect(m_session, &HelperSession::output, this, &PackageManager::onSessionOutput);
+    connect(m_session, &HelperSession::finished, this, &PackageManager::onSessionFinished);
+    connect(m_session, &HelperSession::closed, this, &PackageManager::onSessionClosed);
+    m_session->open();
+}
+
+void PackageManager::closePrivilegedSession()
+{
+    // The helper finishes the running command before it reads the EOF
+    if (m_session)
+        m_session->close();
+}
+
+void PackageManager::onSessionOutput(int id, const QByteArray &line)
+{
+    if (id == m_sessionRequest || id == m_aurSessionRequest)
+        appendOutput(line + '\n');
+}
+
+void PackageManager::onSessionFinished(int id, int exitCode)
+{
+    if (id >= 0 && id == m_aurSessionRequest) {
+        m_aurSessionRequest = -1;
+        finishAurStep(exitCode);
+        return;
+    }
+    if (id != m_sessionRequest)
+        return;
+
+    m_sessionRequest = -1;
+    m_record.exitCode = exitCode;
+    finishOperation(exitCode == 0,
+                    exitCode == 0 ? QString() : tr("Operation failed with exit code %1").arg(exitCode));
+}
+
+void PackageManager::onSessionClosed()
 {
-    startPrivilegedOperation({"regenerate-grub"}, OperationType::RegenerateGrubConfig);
+    m_session->deleteLater();
+    m_session = nullptr;
+
+    if (m_aurSessionRequest >= 0) {
+        m_aurSessionRequest = -1;
+        finishAurStep(-1);
+    }
+    if (m_sessionRequest >= 0) {
+        m_sessionRequest = -1;
+        finishOperation(false, tr("The privileged session ended unexpectedly"));
+    }
+    emit privilegedSessionChanged(false, {});
 }
 
 void PackageManager::cancelOperation()
 {
+    if (m_mirrorProbe != 0) {
+        qDebug() << "Canceling before the transaction: mirror probe still running";
+        m_mirrorProbe = 0;
+        emit operationFinished(false, tr("Operation was canceled by the user"));
+        return;
+    }
+
+    if (m_aurBuilder->isRunning()) {
+        qDebug() << "Canceling AUR build";
+        m_aurBuilder->cancel();
+        if (m_aurStepProcess) {
+            m_aurStepProcess->disconnect(this);
+            m_aurStepProcess->kill();
+            m_aurStepProcess->waitForFinished(3000);
+            m_aurStepProcess->deleteLater();
+            m_aurStepProcess = nullptr;
+        }
+        if (m_aurStepTimer) {
+            m_aurStepTimer->stop();
+            m_aurStepTimer->deleteLater();
+            m_aurStepTimer = nullptr;
+        }
+        // A step inside the root helper cannot be interrupted; stop the
+        // session from taking further requests
+        if (m_aurSessionRequest >= 0)
+            closePrivilegedSession();
+        return;
+    }
+
+    if (m_replayTimer) {
+        qDebug() << "Canceling replayed operation";
+        m_replayTimer->stop();
+        m_replayTimer->deleteLater();
+        m_replayTimer = nullptr;
+        finishOperation(false, tr("Operation was canceled by the user"));
+        return;
+    }
+
+    if (m_sessionRequest >= 0) {
+        // A command cannot be interrupted inside the root helper; ending the
+        // session stops it from taking further requests
+        qDebug() << "Canceling: closing the privileged session after the current command";
+        closePrivilegedSession();
+        return;
+    }
+
     if (m_process && m_process->state() != QProcess::NotRunning) {
         qDebug() << "Canceling current operation";
         m_process->kill();
         m_process->waitForFinished(3000);
-        cleanupProcess();
-        emit operationFinished(false, tr("Operation was canceled by the user"));
+        finishOperation(false, tr("Operation was canceled by the user"));
     }
 }
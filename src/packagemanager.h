@@ -11,10 +11,23 @@
 #ifndef PACKAGEMANAGER_H
 #define PACKAGEMANAGER_H
 
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 #include <QProcess>
+#include <QElapsedTimer>
+
+#include <optional>
+
+#include "fileownershipindex.h"
+#include "mirrorranker.h"
+#include "operationjournal.h"
+#include "syncdbindex.h"
+
+class AurBuilder;
+class HelperSession;
+class QTimer;
 
 /// Type of package operation currently running
 enum class OperationType {
@@ -25,7 +38,21 @@ enum class OperationType {
     AurRemove,
     RemoveKmsHook,
     RegenerateInitramfs,
-    RegenerateGrubConfig
+    RegenerateGrubConfig,
+    Rollback,
+    DkmsBuild,
+    ConfigureEarlyKms,
+    ConfigureRuntimePm,
+    ProfileSwitch,
+    KernelParameters
+};
+
+/// Outcome of the kernel compatibility check run before installing
+struct KernelPreflight {
+    QString error;            // every package/kernel combination that cannot work
+    QStringList suggestions;  // driver/kernel pairs that would work instead
+
+    bool ok() const { return error.isEmpty(); }
 };
 
 class PackageManager : public QObject
@@ -50,12 +77,32 @@ public:
     /// Get the available (repo) version of a package, or empty string
     QString availableVersion(const QString &packageName);
 
-    /// Check which packages from a list are installed
+    /// Check which packages from a list are installed (one pacman query)
     QStringList filterInstalled(const QStringList &packages);
 
-    /// Check which packages from a list are NOT installed
+    /// Check which packages from a list are NOT installed (one pacman query)
     QStringList filterNotInstalled(const QStringList &packages);
 
+    /// Dependencies from the list not satisfied by installed packages,
+    /// honouring provides (pacman -T)
+    QStringList unsatisfiedDependencies(const QStringList &deps);
+
+    /// Names listed in a relation field of `pacman -Qi` (local) or
+    /// `pacman -Si` (sync), e.g. "Provides" or "Conflicts With", with
+    /// version constraints stripped
+    QStringList packageRelations(const QString &packageName, const QString &field, bool local);
+
+    /// Check driver packages against every installed kernel before anything
+    /// is downloaded: the kernel range from the profile data
+    /// (DriverProfileManager::kernelCompatibility) and the kernel version
+    /// constraints in each repo package's depends. Failing packages come
+    /// with the kernels, installed or in the repos, they would work with.
+    KernelPreflight checkKernelCompatibility(const QStringList &packages);
+
+    /// Search the sync repositories like `pacman -Ss` (name, provides and
+    /// description), from the in-process index instead of a pacman run
+    QList<SyncPackage> searchRepositories(const QString &query, int limit = -1);
+
     /// Detect AUR helper (yay, paru, etc.) available on the system
     QString findAurHelper();
 
@@ -74,9 +121,59 @@ public:
     /// Check if 'kms' hook is present in mkinitcpio.conf HOOKS
     bool isKmsHookPresent() const;
 
+    /// Kernel + initrd + userspace time of the current boot in milliseconds,
+    /// from systemd-analyze; -1 if unavailable (or boot not finished yet)
+    qint64 bootTimeMs() const;
+
+    /// Change in boot time since early KMS was configured, in milliseconds
+    /// (negative = faster). Empty until the system has been rebooted after
+    /// configureEarlyKms() or if systemd-analyze is unavailable.
+    std::optional<qint64> earlyKmsBootDeltaMs() const;
+
+    /// Parameters the running kernel was booted with (/proc/cmdline)
+    QStringList currentKernelParameters() const;
+
+    /// Get the package owning a file, using the cached local DB index
+    QString fileOwner(const QString &path);
+
+    /// Get the package that provides a loaded kernel module, or empty string.
+    /// Resolves the module's .ko path via modinfo; for DKMS-built modules the
+    /// owner of the DKMS source tree in /usr/src is returned instead.
+    QString kernelModuleOwner(const QString &module);
+
+    /// Firmware files a kernel module may request, relative to
+    /// /usr/lib/firmware (`modinfo -F firmware`); empty if the module is not
+    /// installed or needs none. Cached per module.
+    QStringList moduleFirmware(const QString &module);
+
+    /// Split linux-firmware packages (linux-firmware-amdgpu, -intel, ...)
+    /// shipping the given firmware files: the owner of each installed file,
+    /// otherwise the split package for its directory, if the repos have it.
+    /// Files shipped with a proprietary driver itself are skipped.
+    QStringList firmwarePackages(const QStringList &firmwareFiles);
+
+    /// Whether a package ships DKMS module sources (name ends in "-dkms").
+    /// Transactions containing one defer the DKMS hook to a parallel build.
+    static bool isDkmsPackage(const QString &packageName);
+
     /// Get the path to the privileged helper script
     static QString pkHelperPath();
 
+    /// Directory holding the pre-transaction snapshots taken by the helper
+    static QString snapshotDirectory();
+
+    /// Ids of available rollback snapshots, newest first
+    QStringList availableSnapshots() const;
+
+    /// Journal every finished operation is appended to
+    const OperationJournal &journal() const { return m_journal; }
+
+    /// Stable machine-readable name of an operation type, e.g. "pacman_install"
+    static QString operationName(OperationType type);
+
+    /// Whether privileged operations currently go through a helper session
+    bool hasPrivilegedSession() const;
+
 signals:
     /// Emitted for each line of output from an async operation
     void operationOutput(const QString &line);
@@ -87,6 +184,12 @@ signals:
     /// Emitted when an async operation starts
     void operationStarted(OperationType type);
 
+    /// Emitted for each AUR pkgbase built during installAurPackages
+    void aurPackageBuilt(const QString &pkgbase, bool success, qint64 elapsedMs);
+
+    /// Emitted when a privileged session was opened, failed to open, or ended
+    void privilegedSessionChanged(bool open, const QString &errorMessage);
+
 public slots:
     // ===== Async pacman operations (with privilege escalation) =====
 
@@ -96,9 +199,15 @@ public slots:
     /// Remove packages via pacman (uses pkexec for root access)
     void removePackages(const QStringList &packages);
 
+    /// Switch driver profiles in one helper run: install the missing
+    /// packages (replacing conflicting ones), then remove the given packages
+    /// where nothing else still needs them
+    void switchPackages(const QStringList &install, const QStringList &remove);
+
     // ===== Async AUR operations (runs as current user) =====
 
-    /// Install packages via the detected AUR helper
+    /// Build and install AUR packages; independent pkgbases are built in
+    /// parallel with the managed makepkg.conf (see AurBuilder)
     void installAurPackages(const QStringList &packages);
 
     /// Remove AUR packages (falls back to pacman if no AUR helper)
@@ -112,37 +221,132 @@ public slots:
     /// Regenerate initramfs via mkinitcpio -P
     void regenerateInitramfs();
 
-    /// Regenerate bootloader configuration (GRUB / systemd-boot)
-    void regenerateGrubConfig();
+    /// Regenerate bootloader configuration (GRUB / systemd-boot). The
+    /// helper skips grub-mkconfig if none of its inputs changed since the
+    /// last run, unless force is set.
+    void regenerateGrubConfig(bool force = false);
+
+    /// Add (or remove) kernel command-line parameters in /etc/default/grub,
+    /// systemd-boot entries and /etc/kernel/cmdline, whichever exist, and
+    /// regenerate only the boot files whose command line changed
+    void updateKernelParameters(const QStringList &parameters, bool add = true);
+
+    /// Load the given kernel modules from the initramfs (early KMS) and
+    /// regenerate it; the helper reports the resulting image sizes
+    void configureEarlyKms(const QStringList &modules);
+
+    /// Undo configureEarlyKms() and regenerate the initramfs. Removing or
+    /// switching away from a profile does this by itself once its modules
+    /// are gone.
+    void disableEarlyKms();
+
+    /// Enable or disable NVIDIA runtime D3 (modprobe option + udev rules);
+    /// withPowerd also enables nvidia-powerd. Callers decide applicability
+    /// with HardwareDetector::supportsRuntimeD3 / supportsNvidiaPowerd.
+    void configureRuntimePowerManagement(bool enable, bool withPowerd = false);
+
+    /// Build and install all DKMS modules for every installed kernel, with
+    /// the kernels built in parallel
+    void rebuildDkmsModules();
+
+    /// Restore the package versions and boot configuration recorded before
+    /// an install/remove, using only the local pacman cache. An empty id
+    /// selects the most recent snapshot.
+    void rollback(const QString &snapshotId = QString());
+
+    // ===== Privileged session =====
+
+    /// Authorize once and keep the helper running: until the session is
+    /// closed, privileged operations are sent to it instead of starting a
+    /// new pkexec each. Use around multi-step work such as install, early
+    /// KMS and bootloader regeneration.
+    void openPrivilegedSession();
+
+    /// End the session; later operations use one pkexec each again
+    void closePrivilegedSession();
 
     /// Cancel the currently running operation
     void cancelOperation();
 
 private slots:
+    void onProcessStarted();
     void onProcessReadyRead();
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onProcessError(QProcess::ProcessError error);
+    void onAurBuilderOutput(const QString &line);
+    void onAurPrivilegedCommand(const QStringList &helperArgs);
+    void onSessionOutput(int id, const QByteArray &line);
+    void onSessionFinished(int id, int exitCode);
+    void onSessionClosed();
 
 private:
     /// Run a command synchronously, return (stdout, exitCode)
     QPair<QString, int> runCommand(const QString &command, const QStringList &args) const;
 
+    /// Helper arguments selecting the probed mirror order and a tuned
+    /// ParallelDownloads value; empty if no mirror answered
+    static QStringList mirrorArguments(const QList<MirrorProbe> &probes);
+
+    /// Start a package transaction as `helperArgs + mirror arguments +
+    /// packages`. Mirrors are probed on the process pool first (unless
+    /// ranking is disabled), which counts as part of the operation.
+    void startRankedTransaction(const QStringList &helperArgs, const QStringList &packages,
+                                OperationType type);
+
+    /// Install state of each package, in order, via one multi-target `pacman -Q`
+    QList<bool> queryInstalled(const QStringList &packages) const;
+
     /// Start a privileged operation via pkexec + helper script
     void startPrivilegedOperation(const QStringList &helperArgs, OperationType type);
 
     /// Start a user-level operation (e.g., AUR helper)
     void startUserOperation(const QString &command, const QStringList &args, OperationType type);
 
+    /// Serve an async operation from the system-access replay bundle
+    void replayOperation(const QString &program, const QStringList &args, OperationType type);
+
+    /// Record an AUR build's helper step for the bundle and hand its exit
+    /// code (-1 if it did not finish normally) back to the builder
+    void finishAurStep(int exitCode);
+
+    /// Journal a chunk of operation output and emit it line by line
+    void appendOutput(const QByteArray &data);
+
+    /// Begin a journal record for an operation about to start
+    void beginRecord(OperationType type, const QString &program, const QStringList &args);
+
     /// Set up the QProcess for a new async operation
     void setupProcess();
 
     /// Clean up after an operation completes
     void cleanupProcess();
 
+    /// Report timing, clean up and emit operationFinished
+    void finishOperation(bool success, const QString &errorMessage);
+
     QProcess *m_process = nullptr;
+    AurBuilder *m_aurBuilder = nullptr;
+    HelperSession *m_session = nullptr;
+    int m_sessionRequest = -1;     // id of the operation running in the session
+    int m_aurSessionRequest = -1;  // id of an AUR build's helper step in the session
+    int m_mirrorProbe = 0;         // id of the running mirror probe, 0 if none
+    int m_lastMirrorProbe = 0;
+    QProcess *m_aurStepProcess = nullptr; // one-shot pkexec for an AUR build's helper step
+    QTimer *m_aurStepTimer = nullptr;     // replayed AUR build helper step
+    QStringList m_aurStepArgs;            // pkexec arguments of the step, as in a bundle
+    qsizetype m_aurStepOutputStart = 0;   // where its output starts in m_record
+    QElapsedTimer m_aurStepElapsed;
+    QTimer *m_replayTimer = nullptr;
     OperationType m_currentOperation = OperationType::None;
+    QElapsedTimer m_operationTimer;
+    OperationJournal m_journal;
+    OperationRecord m_record;
     QString m_cachedAurHelper;
     bool m_aurHelperDetected = false;
+    FileOwnershipIndex m_ownershipIndex;
+    SyncDbIndex m_syncIndex;
+    QHash<QString, QStringList> m_moduleFirmware;    // module -> firmware files
+    QHash<QString, bool> m_firmwarePackageAvailable; // split package -> in the repos
 };
 
 #endif // PACKAGEMANAGER_H
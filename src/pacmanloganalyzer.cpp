@@ -0,0 +1,430 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "pacmanloganalyzer.h"
+#include "driverprofile.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 kCacheMagic = 0x5253504c;   // "RSPL"
+constexpr quint32 kCacheVersion = 1;
+
+/// Leading bytes compared to recognise the same log after rotation
+constexpr qint64 kHeadBytes = 256;
+
+struct ActionWord {
+    QByteArrayView word;
+    PackageChange::Action action;
+};
+
+const ActionWord kActionWords[] = {
+    {"installed ",   PackageChange::Action::Installed},
+    {"upgraded ",    PackageChange::Action::Upgraded},
+    {"downgraded ",  PackageChange::Action::Downgraded},
+    {"reinstalled ", PackageChange::Action::Reinstalled},
+    {"removed ",     PackageChange::Action::Removed},
+};
+
+/// Hooks whose run time is recorded
+bool isTrackedHook(QByteArrayView name)
+{
+    return name.contains(QByteArrayView("dkms")) || name.contains(QByteArrayView("mkinitcpio"))
+        || name.contains(QByteArrayView("nvidia"));
+}
+
+/// pacman >= 5.1 writes "2024-05-01T12:34:56+0200", older versions
+/// "2018-06-01 12:34"
+QDateTime parseTimestamp(QByteArrayView stamp)
+{
+    const QString text = QString::fromLatin1(stamp);
+    QDateTime time = QDateTime::fromString(text, Qt::ISODate);
+    if (!time.isValid())
+        time = QDateTime::fromString(text, "yyyy-MM-dd HH:mm");
+    return time;
+}
+
+/// "nvidia-utils (550.67-1 -> 550.78-1)" after the action word
+std::optional<PackageChange> parseChange(PackageChange::Action action, QByteArrayView rest,
+                                         const QSet<QByteArray> &packages)
+{
+    const qsizetype space = rest.indexOf(' ');
+    if (space <= 0)
+        return std::nullopt;
+    // Most lines are about other packages; look the name up without a copy
+    if (!packages.contains(QByteArray::fromRawData(rest.data(), space)))
+        return std::nullopt;
+
+    QByteArrayView versions = rest.sliced(space + 1);
+    if (!versions.startsWith('(') || !versions.endsWith(')'))
+        return std::nullopt;
+    versions = versions.sliced(1, versions.size() - 2);
+
+    PackageChange change;
+    change.action = action;
+    change.package = QString::fromUtf8(rest.first(space));
+    switch (action) {
+    case PackageChange::Action::Installed:
+        change.newVersion = QString::fromUtf8(versions);
+        break;
+    case PackageChange::Action::Removed:
+        change.oldVersion = QString::fromUtf8(versions);
+        break;
+    case PackageChange::Action::Reinstalled:
+        change.oldVersion = change.newVersion = QString::fromUtf8(versions);
+        break;
+    case PackageChange::Action::Upgraded:
+    case PackageChange::Action::Downgraded: {
+        const qsizetype arrow = versions.indexOf(QByteArrayView(" -> "));
+        if (arrow < 0)
+            return std::nullopt;
+        change.oldVersion = QString::fromUtf8(versions.first(arrow));
+        change.newVersion = QString::fromUtf8(versions.sliced(arrow + 4));
+        break;
+    }
+    }
+    return change;
+}
+
+void writeTransaction(QDataStream &out, const DriverTransaction &t)
+{
+    out << t.offset << t.endOffset << t.command << t.started << t.durationMs;
+    out << quint32(t.changes.size());
+    for (const PackageChange &c : t.changes)
+        out << quint8(c.action) << c.package << c.oldVersion << c.newVersion;
+    out << quint32(t.hooks.size());
+    for (const HookRun &h : t.hooks)
+        out << h.name << h.durationMs;
+}
+
+DriverTransaction readTransaction(QDataStream &in)
+{
+    DriverTransaction t;
+    quint32 count = 0;
+    in >> t.offset >> t.endOffset >> t.command >> t.started >> t.durationMs >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        PackageChange c;
+        quint8 action = 0;
+        in >> action >> c.package >> c.oldVersion >> c.newVersion;
+        c.action = PackageChange::Action(action);
+        t.changes.append(c);
+    }
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        HookRun h;
+        in >> h.name >> h.durationMs;
+        t.hooks.append(h);
+    }
+    return t;
+}
+
+} // namespace
+
+PacmanLogAnalyzer::PacmanLogAnalyzer(const QString &logPath, const QStringList &packages)
+    : m_logPath(logPath)
+{
+    QStringList sorted = packages;
+    sorted.sort();
+    sorted.removeDuplicates();
+    for (const QString &package : std::as_const(sorted))
+        m_packages.insert(package.toUtf8());
+    m_filterKey = QCryptographicHash::hash(sorted.join('\n').toUtf8(), QCryptographicHash::Sha1);
+}
+
+QString PacmanLogAnalyzer::defaultLogPath()
+{
+    const QString env = qEnvironmentVariable("RSCN_PACMAN_LOG");
+    return env.isEmpty() ? QStringLiteral("/var/log/pacman.log") : env;
+}
+
+QStringList PacmanLogAnalyzer::driverProfilePackages()
+{
+    QStringList packages;
+    for (const DriverProfile &profile : DriverProfileManager::getAllProfiles())
+        packages << profile.requiredPackages << profile.optionalPackages;
+    packages.removeDuplicates();
+    return packages;
+}
+
+QString PacmanLogAnalyzer::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+           + "/rscn-drivers/pacman-log.idx";
+}
+
+QString PacmanLogAnalyzer::actionName(PackageChange::Action action)
+{
+    switch (action) {
+    case PackageChange::Action::Installed:   return "installed";
+    case PackageChange::Action::Upgraded:    return "upgraded";
+    case PackageChange::Action::Downgraded:  return "downgraded";
+    case PackageChange::Action::Reinstalled: return "reinstalled";
+    case PackageChange::Action::Removed:     return "removed";
+    }
+    return {};
+}
+
+QList<DriverTransaction> PacmanLogAnalyzer::history()
+{
+    m_lastParsedBytes = 0;
+
+    QFile file(m_logPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open pacman log" << m_logPath;
+        return m_transactions;
+    }
+    const qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data)
+        return {};
+    const char *text = reinterpret_cast<const char *>(data);
+    const QByteArray head(text, qMin(size, kHeadBytes));
+
+    if (!m_loaded) {
+        m_loaded = true;
+        loadCache(head, size);
+    }
+
+    // Rotated or truncated since: start over
+    if (m_resumeOffset > size || !head.startsWith(m_head)) {
+        m_transactions.clear();
+        m_resumeOffset = 0;
+    }
+    m_head = head;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const qint64 from = m_resumeOffset;
+    const std::optional<DriverTransaction> open = parse(text, size);
+    if (m_resumeOffset != from)
+        saveCache();
+
+    qDebug() << "pacman.log:" << m_lastParsedBytes << "new bytes parsed in" << timer.elapsed()
+             << "ms," << m_transactions.size() << "driver transactions";
+
+    QList<DriverTransaction> transactions = m_transactions;
+    if (open)
+        transactions.append(*open);
+    return transactions;
+}
+
+QByteArray PacmanLogAnalyzer::excerpt(const DriverTransaction &transaction) const
+{
+    QFile file(m_logPath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(transaction.offset))
+        return {};
+    return file.read(transaction.endOffset - transaction.offset);
+}
+
+// ---------------------------------------------------------------------------
+// Parsing
+// ---------------------------------------------------------------------------
+
+std::optional<DriverTransaction> PacmanLogAnalyzer::parse(const char *data, qint64 size)
+{
+    // Only complete lines; a line pacman is still writing is read next time
+    const void *lastNewline = memrchr(data + m_resumeOffset, '\n', size_t(size - m_resumeOffset));
+    if (!lastNewline)
+        return std::nullopt;
+    const qint64 end = static_cast<const char *>(lastNewline) - data + 1;
+    m_lastParsedBytes = end - m_resumeOffset;
+
+    // One pacman run: from its "Running '...'" line to the next one, so
+    // the post-transaction hooks belong to it
+    std::optional<DriverTransaction> current;
+    qsizetype openHook = -1;
+    QDateTime hookStarted;
+    QByteArrayView lastStamp;
+
+    qint64 pos = m_resumeOffset;
+    while (pos < end) {
+        const qint64 lineOffset = pos;
+        const char *newline = static_cast<const char *>(
+            std::memchr(data + pos, '\n', size_t(end - pos)));
+        const QByteArrayView line(data + pos, newline - (data + pos));
+        pos = newline - data + 1;
+
+        // "[2024-05-01T12:34:56+0200] [ALPM] upgraded nvidia-utils (...)"
+        if (line.size() < 4 || line.front() != '[')
+            continue;
+        const char *close = static_cast<const char *>(
+            std::memchr(line.data(), ']', size_t(qMin<qsizetype>(line.size(), 40))));
+        if (!close)
+            continue;
+        const QByteArrayView stamp(line.data() + 1, close - line.data() - 1);
+        QByteArrayView rest = line.sliced(close - line.data() + 1);
+
+        bool fromPacman = false;
+        if (rest.startsWith(QByteArrayView(" [ALPM] "))) {
+            rest = rest.sliced(8);
+        } else if (rest.startsWith(QByteArrayView(" [PACMAN] "))) {
+            rest = rest.sliced(10);
+            fromPacman = true;
+        } else {
+            // Scriptlet output and other front-ends
+            continue;
+        }
+
+        // A hook lasts until pacman logs its next line
+        if (openHook >= 0) {
+            current->hooks[openHook].durationMs = hookStarted.msecsTo(parseTimestamp(stamp));
+            openHook = -1;
+        }
+        lastStamp = stamp;
+
+        if (fromPacman) {
+            if (rest.startsWith(QByteArrayView("Running '"))) {
+                finish(current);
+                current = DriverTransaction();
+                current->offset = lineOffset;
+                current->command = QString::fromUtf8(rest.sliced(9).chopped(rest.endsWith('\'') ? 1 : 0));
+            }
+        } else if (rest == QByteArrayView("transaction started")) {
+            // Front-ends that do not log a command line
+            if (!current || current->started.isValid()) {
+                finish(current);
+                current = DriverTransaction();
+                current->offset = lineOffset;
+            }
+            current->started = parseTimestamp(stamp);
+        } else if (!current) {
+            continue;
+        } else if (rest == QByteArrayView("transaction completed")) {
+            if (current->started.isValid())
+                current->durationMs = current->started.msecsTo(parseTimestamp(stamp));
+        } else if (rest.startsWith(QByteArrayView("running '"))) {
+            // "running '70-dkms-install.hook'..."
+            QByteArrayView name = rest.sliced(9);
+            const qsizetype quote = name.indexOf('\'');
+            if (quote > 0)
+                name = name.first(quote);
+            if (isTrackedHook(name)) {
+                current->hooks.append({QString::fromUtf8(name), -1});
+                openHook = current->hooks.size() - 1;
+                hookStarted = parseTimestamp(stamp);
+            }
+        } else {
+            for (const ActionWord &word : kActionWords) {
+                if (!rest.startsWith(word.word))
+                    continue;
+                if (const auto change = parseChange(word.action, rest.sliced(word.word.size()), m_packages))
+                    current->changes.append(*change);
+                break;
+            }
+        }
+
+        if (current)
+            current->endOffset = pos;
+    }
+
+    if (!current) {
+        m_resumeOffset = end;
+        return std::nullopt;
+    }
+
+    // The last run is parsed again next time, with whatever pacman adds
+    m_resumeOffset = current->offset;
+    if (openHook >= 0)
+        current->hooks[openHook].durationMs = hookStarted.msecsTo(parseTimestamp(lastStamp));
+
+    const qsizetype finished = m_transactions.size();
+    finish(current);
+    if (m_transactions.size() == finished)
+        return std::nullopt;
+    return m_transactions.takeLast();
+}
+
+void PacmanLogAnalyzer::finish(std::optional<DriverTransaction> &transaction)
+{
+    if (!transaction)
+        return;
+
+    // Kernel updates count too when they rebuilt DKMS modules
+    const bool rebuiltDkms = std::any_of(transaction->hooks.cbegin(), transaction->hooks.cend(),
+                                         [](const HookRun &h) { return h.name.contains("dkms"); });
+    if (!transaction->changes.isEmpty() || rebuiltDkms)
+        m_transactions.append(*transaction);
+    transaction.reset();
+}
+
+// ---------------------------------------------------------------------------
+// Offset index cache
+// ---------------------------------------------------------------------------
+
+bool PacmanLogAnalyzer::loadCache(const QByteArray &head, qint64 logSize)
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != kCacheMagic || version != kCacheVersion)
+        return false;
+
+    QString logPath;
+    QByteArray filterKey;
+    QByteArray cachedHead;
+    qint64 resumeOffset = 0;
+    quint32 count = 0;
+    in >> logPath >> filterKey >> cachedHead >> resumeOffset >> count;
+    if (in.status() != QDataStream::Ok || logPath != m_logPath || filterKey != m_filterKey
+        || resumeOffset > logSize || !head.startsWith(cachedHead))
+        return false;
+
+    QList<DriverTransaction> transactions;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+        transactions.append(readTransaction(in));
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Discarding damaged pacman log index" << file.fileName();
+        return false;
+    }
+
+    m_transactions = transactions;
+    m_resumeOffset = resumeOffset;
+    m_head = cachedHead;
+    return true;
+}
+
+void PacmanLogAnalyzer::saveCache() const
+{
+    const QString path = cachePath();
+    QDir().mkpath(QFileInfo(path).path());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write pacman log index" << path;
+        return;
+    }
+
+    QDataStream out(&file);
+    out << kCacheMagic << kCacheVersion << m_logPath << m_filterKey << m_head
+        << m_resumeOffset << quint32(m_transactions.size());
+    for (const DriverTransaction &transaction : m_transactions)
+        writeTransaction(out, transaction);
+
+    if (!file.commit())
+        qWarning() << "Failed to write pacman log index" << path;
+}
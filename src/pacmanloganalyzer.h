@@ -0,0 +1,108 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef PACMANLOGANALYZER_H
+#define PACMANLOGANALYZER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+/// A package change recorded in pacman.log
+struct PackageChange {
+    enum class Action { Installed, Upgraded, Downgraded, Reinstalled, Removed };
+
+    Action action = Action::Installed;
+    QString package;
+    QString oldVersion;   // empty for Installed
+    QString newVersion;   // empty for Removed
+};
+
+/// A hook pacman ran after a transaction
+struct HookRun {
+    QString name;             // e.g. "70-dkms-install.hook"
+    qint64 durationMs = -1;   // until pacman logged its next line; -1 if unknown
+};
+
+/// One pacman run that changed a driver package or rebuilt DKMS modules
+struct DriverTransaction {
+    qint64 offset = 0;            // log byte offset of its first line
+    qint64 endOffset = 0;         // log byte offset just past its last line
+    QString command;              // "pacman -Syu", as logged by pacman
+    QDateTime started;
+    qint64 durationMs = -1;       // "transaction started" to "completed"; -1 if it never completed
+    QList<PackageChange> changes; // driver packages only
+    QList<HookRun> hooks;         // DKMS, initramfs and NVIDIA hooks
+};
+
+/// Driver change history from /var/log/pacman.log.
+///
+/// The log is mmapped and split into lines with memchr, which glibc
+/// vectorizes; only [ALPM] and [PACMAN] lines are looked at further, and a
+/// package name is only decoded once it is known to be a driver package.
+/// The transactions found and the offset parsing stopped at are kept in
+/// ~/.cache/rscn-drivers/pacman-log.idx, so a later query only parses what
+/// pacman appended since. A rotated or truncated log is parsed afresh.
+class PacmanLogAnalyzer
+{
+public:
+    explicit PacmanLogAnalyzer(const QString &logPath = defaultLogPath(),
+                               const QStringList &packages = driverProfilePackages());
+
+    /// $RSCN_PACMAN_LOG, or /var/log/pacman.log
+    static QString defaultLogPath();
+
+    /// Required and optional packages of every driver profile
+    static QStringList driverProfilePackages();
+
+    /// Location of the on-disk index
+    static QString cachePath();
+
+    /// Transactions touching the packages or running a DKMS hook, oldest
+    /// first; parses only the part of the log not seen before
+    QList<DriverTransaction> history();
+
+    /// The log lines of a transaction
+    QByteArray excerpt(const DriverTransaction &transaction) const;
+
+    /// Bytes parsed by the last history() call
+    qint64 lastParsedBytes() const { return m_lastParsedBytes; }
+
+    static QString actionName(PackageChange::Action action);
+
+private:
+    /// Parse from m_resumeOffset to the last complete line, moving finished
+    /// transactions to m_transactions. The pacman run at the end of the log
+    /// may still get lines; it is returned as it stands and parsed again
+    /// next time.
+    std::optional<DriverTransaction> parse(const char *data, qint64 size);
+
+    /// Hand a transaction over to m_transactions if it concerns drivers
+    void finish(std::optional<DriverTransaction> &transaction);
+
+    bool loadCache(const QByteArray &head, qint64 logSize);
+    void saveCache() const;
+
+    QString m_logPath;
+    QSet<QByteArray> m_packages;
+    QByteArray m_filterKey;                  // identifies the package set in the cache
+    QByteArray m_head;                       // first bytes of the log; changes on rotation
+    QList<DriverTransaction> m_transactions; // finished ones, before m_resumeOffset
+    qint64 m_resumeOffset = 0;
+    qint64 m_lastParsedBytes = 0;
+    bool m_loaded = false;
+};
+
+#endif // PACMANLOGANALYZER_H
@@ -0,0 +1,113 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "processexecutor.h"
+
+#include <QMutex>
+#include <QPromise>
+#include <QThread>
+
+#include <memory>
+
+ProcessExecutor &ProcessExecutor::instance()
+{
+    static ProcessExecutor executor;
+    return executor;
+}
+
+ProcessExecutor::ProcessExecutor()
+{
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+    // Workers only wait on child processes; let idle ones go quickly
+    m_pool.setExpiryTimeout(5000);
+}
+
+void ProcessExecutor::setMaxConcurrency(int count)
+{
+    m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+int ProcessExecutor::maxConcurrency() const
+{
+    return m_pool.maxThreadCount();
+}
+
+QFuture<CommandResult> ProcessExecutor::submit(const QString &program, const QStringList &args, int timeoutMs)
+{
+    auto promise = std::make_shared<QPromise<CommandResult>>();
+    QFuture<CommandResult> future = promise->future();
+    promise->start();
+
+    m_pool.start([promise, program, args, timeoutMs]() {
+        promise->addResult(SystemAccess::instance().run(program, args, timeoutMs));
+        promise->finish();
+    });
+    return future;
+}
+
+QFuture<CommandResult> ProcessExecutor::submit(const CommandSpec &spec)
+{
+    return submit(spec.program, spec.args, spec.timeoutMs);
+}
+
+QList<CommandResult> ProcessExecutor::runAll(const QList<CommandSpec> &specs)
+{
+    // A single command gains nothing from a worker thread
+    if (specs.size() == 1)
+        return {SystemAccess::instance().run(specs.first().program, specs.first().args, specs.first().timeoutMs)};
+
+    QList<QFuture<CommandResult>> futures;
+    futures.reserve(specs.size());
+    for (const CommandSpec &spec : specs)
+        futures.append(submit(spec));
+
+    QList<CommandResult> results;
+    results.reserve(specs.size());
+    for (QFuture<CommandResult> &future : futures)
+        results.append(future.result());
+    return results;
+}
+
+QFuture<QList<CommandResult>> ProcessExecutor::submitAll(const QList<CommandSpec> &specs)
+{
+    auto promise = std::make_shared<QPromise<QList<CommandResult>>>();
+    QFuture<QList<CommandResult>> future = promise->future();
+    promise->start();
+
+    if (specs.isEmpty()) {
+        promise->addResult(QList<CommandResult>());
+        promise->finish();
+        return future;
+    }
+
+    // Workers only report into the batch, so none of them waits on another
+    struct Batch {
+        QMutex mutex;
+        QList<CommandResult> results;
+        qsizetype pending = 0;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->results.resize(specs.size());
+    batch->pending = specs.size();
+
+    for (qsizetype i = 0; i < specs.size(); ++i) {
+        const CommandSpec spec = specs.at(i);
+        m_pool.start([promise, batch, spec, i]() {
+            CommandResult result = SystemAccess::instance().run(spec.program, spec.args, spec.timeoutMs);
+            QMutexLocker locker(&batch->mutex);
+            batch->results[i] = std::move(result);
+            if (--batch->pending == 0) {
+                promise->addResult(batch->results);
+                promise->finish();
+            }
+        });
+    }
+    return future;
+}
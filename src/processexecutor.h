@@ -0,0 +1,63 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef PROCESSEXECUTOR_H
+#define PROCESSEXECUTOR_H
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "systemaccess.h"
+
+/// A command to run through the executor
+struct CommandSpec {
+    QString program;
+    QStringList args;
+    int timeoutMs = 10000;
+};
+
+/// Runs short-lived query commands (pacman -Q, which, modinfo, ...) on a
+/// dedicated thread pool, so independent queries overlap instead of
+/// blocking one after another.
+///
+/// Commands still go through SystemAccess, so record and replay apply.
+/// Results are delivered as QFutures; attach callbacks with QFuture::then()
+/// or block on a whole batch with runAll().
+class ProcessExecutor
+{
+public:
+    static ProcessExecutor &instance();
+
+    /// Maximum number of commands running at once (default: ideal thread count)
+    void setMaxConcurrency(int count);
+    int maxConcurrency() const;
+
+    /// Start a command; the future resolves when it exits or times out
+    QFuture<CommandResult> submit(const QString &program, const QStringList &args, int timeoutMs = 10000);
+    QFuture<CommandResult> submit(const CommandSpec &spec);
+
+    /// Run a batch concurrently and wait for all of it; results are in the
+    /// order of the specs
+    QList<CommandResult> runAll(const QList<CommandSpec> &specs);
+
+    /// Start a batch concurrently; the future resolves with all results, in
+    /// the order of the specs, once the last command exits
+    QFuture<QList<CommandResult>> submitAll(const QList<CommandSpec> &specs);
+
+private:
+    ProcessExecutor();
+
+    QThreadPool m_pool;
+};
+
+#endif // PROCESSEXECUTOR_H
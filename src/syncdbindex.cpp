@@ -0,0 +1,607 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "syncdbindex.h"
+#include "systemaccess.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr quint32 kCacheMagic = 0x52534442;   // "RSDB"
+constexpr quint32 kCacheVersion = 1;
+
+constexpr qsizetype kTarBlock = 512;
+
+/// desc members are a few KB; anything larger is not one
+constexpr qint64 kMaxMemberSize = 1024 * 1024;
+
+/// Size of the inflate output buffer
+constexpr qsizetype kInflateChunk = 256 * 1024;
+
+/// Walks a tar stream fed in arbitrary chunks and hands the contents of
+/// every regular member named ".../desc" to a callback. GNU long names and
+/// pax path records are honoured; all other members are skipped unread.
+class TarDescReader
+{
+public:
+    explicit TarDescReader(std::function<void(QByteArrayView)> onDesc)
+        : m_onDesc(std::move(onDesc))
+    {
+    }
+
+    void feed(const char *data, qsizetype size)
+    {
+        m_pending.append(data, size);
+
+        qsizetype pos = 0;
+        while (true) {
+            if (m_skip > 0) {
+                const qsizetype n = std::min<qsizetype>(m_skip, m_pending.size() - pos);
+                pos += n;
+                m_skip -= n;
+                if (m_skip > 0)
+                    break;
+            }
+
+            if (m_kind != Kind::None) {
+                const qsizetype padded = roundUp(m_bodySize);
+                if (m_pending.size() - pos < padded)
+                    break;
+                handleBody(QByteArrayView(m_pending.constData() + pos, m_bodySize));
+                pos += padded;
+                m_kind = Kind::None;
+                continue;
+            }
+
+            if (m_pending.size() - pos < kTarBlock)
+                break;
+            parseHeader(m_pending.constData() + pos);
+            pos += kTarBlock;
+        }
+        m_pending.remove(0, pos);
+    }
+
+private:
+    enum class Kind { None, Desc, LongName, Pax };
+
+    static qsizetype roundUp(qint64 size)
+    {
+        return qsizetype((size + kTarBlock - 1) / kTarBlock * kTarBlock);
+    }
+
+    /// NUL-terminated header field
+    static QByteArray field(const char *data, qsizetype length)
+    {
+        const void *nul = std::memchr(data, '\0', size_t(length));
+        return QByteArray(data, nul ? static_cast<const char *>(nul) - data : length);
+    }
+
+    /// Octal number field, space or NUL padded
+    static qint64 octal(const char *data, qsizetype length)
+    {
+        qint64 value = 0;
+        qsizetype i = 0;
+        while (i < length && data[i] == ' ')
+            ++i;
+        for (; i < length && data[i] >= '0' && data[i] <= '7'; ++i)
+            value = value * 8 + (data[i] - '0');
+        return value;
+    }
+
+    void parseHeader(const char *header)
+    {
+        // Zero blocks pad the end of the archive
+        if (header[0] == '\0')
+            return;
+
+        const qint64 size = octal(header + 124, 12);
+        const char type = header[156];
+
+        QByteArray name;
+        if (!m_nextName.isEmpty()) {
+            name = std::exchange(m_nextName, QByteArray());
+        } else {
+            name = field(header, 100);
+            if (std::memcmp(header + 257, "ustar", 5) == 0) {
+                const QByteArray prefix = field(header + 345, 155);
+                if (!prefix.isEmpty())
+                    name = prefix + '/' + name;
+            }
+        }
+
+        Kind kind = Kind::None;
+        if (type == 'L')
+            kind = Kind::LongName;
+        else if (type == 'x')
+            kind = Kind::Pax;
+        else if ((type == '0' || type == '\0') && (name == "desc" || name.endsWith("/desc")))
+            kind = Kind::Desc;
+
+        if (kind == Kind::None || size > kMaxMemberSize) {
+            m_skip = roundUp(size);
+            return;
+        }
+        m_kind = kind;
+        m_bodySize = size;
+    }
+
+    void handleBody(QByteArrayView body)
+    {
+        switch (m_kind) {
+        case Kind::Desc:
+            m_onDesc(body);
+            break;
+        case Kind::LongName:
+            m_nextName = field(body.data(), body.size());
+            break;
+        case Kind::Pax:
+            // Records are "<length> <key>=<value>\n"
+            for (const QByteArray &record : body.toByteArray().split('\n')) {
+                const qsizetype space = record.indexOf(' ');
+                if (space > 0 && record.sliced(space + 1).startsWith("path="))
+                    m_nextName = record.sliced(space + 6);
+            }
+            break;
+        case Kind::None:
+            break;
+        }
+    }
+
+    std::function<void(QByteArrayView)> m_onDesc;
+    QByteArray m_pending;
+    QByteArray m_nextName;
+    qsizetype m_skip = 0;
+    Kind m_kind = Kind::None;
+    qint64 m_bodySize = 0;
+};
+
+/// Lowercase trigrams of a UTF-8 string, packed into 24 bits, sorted and
+/// deduplicated
+std::vector<quint32> trigrams(const QByteArray &text)
+{
+    std::vector<quint32> grams;
+    if (text.size() < 3)
+        return grams;
+
+    const auto *bytes = reinterpret_cast<const uchar *>(text.constData());
+    grams.reserve(size_t(text.size() - 2));
+    for (qsizetype i = 0; i + 2 < text.size(); ++i)
+        grams.push_back(quint32(bytes[i]) << 16 | quint32(bytes[i + 1]) << 8 | bytes[i + 2]);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+/// The text a package is searched by
+QByteArray searchText(const SyncPackage &package)
+{
+    return (package.name + '\n' + package.provides.join('\n') + '\n' + package.description)
+        .toLower().toUtf8();
+}
+
+// Tables are stored in host byte order: the cache never leaves the machine
+void writeTable(QDataStream &out, const QList<quint32> &table)
+{
+    out << quint32(table.size());
+    out.writeRawData(reinterpret_cast<const char *>(table.constData()), int(table.size() * sizeof(quint32)));
+}
+
+bool readTable(QDataStream &in, QList<quint32> &table, qint64 available)
+{
+    quint32 count = 0;
+    in >> count;
+    if (in.status() != QDataStream::Ok || qint64(count) * qint64(sizeof(quint32)) > available)
+        return false;
+    table.resize(count);
+    const int bytes = int(count * sizeof(quint32));
+    return in.readRawData(reinterpret_cast<char *>(table.data()), bytes) == bytes;
+}
+
+/// Whether every value of a table indexes into a list of the given size
+bool indexesWithin(const QList<quint32> &table, qsizetype size)
+{
+    return std::all_of(table.cbegin(), table.cend(),
+                       [size](quint32 index) { return qsizetype(index) < size; });
+}
+
+/// Whether the trigram ranges ascend and stay within the postings
+bool rangesWithin(const QList<quint32> &start, qsizetype postings)
+{
+    return std::is_sorted(start.cbegin(), start.cend())
+           && (start.isEmpty() || qsizetype(start.last()) <= postings);
+}
+
+} // namespace
+
+SyncDbIndex::SyncDbIndex(const QString &syncDbPath)
+    : m_syncDbPath(syncDbPath)
+{
+}
+
+QString SyncDbIndex::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+           + "/rscn-drivers/syncdb.idx";
+}
+
+QList<SyncPackage> SyncDbIndex::search(const QString &query, int limit)
+{
+    ensureCurrent();
+
+    const QString needle = query.trimmed();
+    if (needle.isEmpty())
+        return {};
+
+    // Shorter queries have no trigram; a scan of the names and descriptions
+    // is still far below a pacman run
+    const QByteArray lowered = needle.toLower().toUtf8();
+    QList<quint32> candidates;
+    if (lowered.size() >= 3) {
+        candidates = trigramCandidates(lowered);
+    } else {
+        candidates.resize(m_packages.size());
+        std::iota(candidates.begin(), candidates.end(), 0u);
+    }
+
+    // Trigrams can also match across the joined fields, so every candidate
+    // is verified
+    QList<QPair<int, quint32>> ranked;
+    for (const quint32 i : std::as_const(candidates)) {
+        const SyncPackage &package = m_packages.at(i);
+        int rank;
+        if (package.name.compare(needle, Qt::CaseInsensitive) == 0)
+            rank = 0;
+        else if (package.name.startsWith(needle, Qt::CaseInsensitive))
+            rank = 1;
+        else if (package.name.contains(needle, Qt::CaseInsensitive))
+            rank = 2;
+        else if (std::any_of(package.provides.cbegin(), package.provides.cend(),
+                             [&](const QString &p) { return p.contains(needle, Qt::CaseInsensitive); }))
+            rank = 3;
+        else if (package.description.contains(needle, Qt::CaseInsensitive))
+            rank = 4;
+        else
+            continue;
+        ranked.append({rank, i});
+    }
+
+    std::stable_sort(ranked.begin(), ranked.end(), [this](const auto &a, const auto &b) {
+        if (a.first != b.first)
+            return a.first < b.first;
+        return m_packages.at(a.second).name < m_packages.at(b.second).name;
+    });
+
+    QList<SyncPackage> results;
+    for (const auto &match : std::as_const(ranked)) {
+        if (limit >= 0 && results.size() >= limit)
+            break;
+        results.append(m_packages.at(match.second));
+    }
+    return results;
+}
+
+QList<SyncPackage> SyncDbIndex::withPrefix(const QString &prefix, int limit)
+{
+    ensureCurrent();
+
+    auto it = std::lower_bound(m_byName.cbegin(), m_byName.cend(), prefix,
+                               [this](quint32 i, const QString &value) {
+        return m_packages.at(i).name.compare(value, Qt::CaseInsensitive) < 0;
+    });
+
+    QList<SyncPackage> results;
+    for (; it != m_byName.cend(); ++it) {
+        const SyncPackage &package = m_packages.at(*it);
+        if (!package.name.startsWith(prefix, Qt::CaseInsensitive)
+            || (limit >= 0 && results.size() >= limit))
+            break;
+        results.append(package);
+    }
+    return results;
+}
+
+void SyncDbIndex::invalidate()
+{
+    m_packages.clear();
+    m_byName.clear();
+    m_trigramKeys.clear();
+    m_trigramStart.clear();
+    m_postings.clear();
+    m_built = false;
+}
+
+void SyncDbIndex::ensureCurrent()
+{
+    // A few stat() calls; cheap enough to repeat on every lookup
+    const QByteArray key = inputsKey();
+    if (m_built && key == m_builtFor)
+        return;
+
+    invalidate();
+    if (!loadCache(key)) {
+        build();
+        saveCache(key);
+    }
+    m_builtFor = key;
+    m_built = true;
+}
+
+QStringList SyncDbIndex::databaseNames() const
+{
+    QStringList names = SystemAccess::instance().entryList(m_syncDbPath);
+    names.removeIf([](const QString &name) { return !name.endsWith(".db"); });
+    return names;
+}
+
+QByteArray SyncDbIndex::inputsKey() const
+{
+    SystemAccess &system = SystemAccess::instance();
+    QByteArray key = m_syncDbPath.toUtf8() + '\n';
+    for (const QString &name : databaseNames()) {
+        const QDateTime modified = system.lastModified(m_syncDbPath + "/" + name);
+        key += name.toUtf8() + ' ' + QByteArray::number(modified.toMSecsSinceEpoch()) + '\n';
+    }
+    return key;
+}
+
+// ---------------------------------------------------------------------------
+// Building
+// ---------------------------------------------------------------------------
+
+void SyncDbIndex::build()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList databases = databaseNames();
+    for (const QString &name : databases)
+        readDatabase(m_syncDbPath + "/" + name, name.chopped(3));
+
+    buildLookupTables();
+
+    qDebug() << "Sync database index:" << m_packages.size() << "packages from"
+             << databases.size() << "databases in" << timer.elapsed() << "ms";
+}
+
+bool SyncDbIndex::readDatabase(const QString &path, const QString &repo)
+{
+    const std::optional<QByteArray> content = SystemAccess::instance().readFile(path);
+    if (!content || content->isEmpty())
+        return false;
+    const qint64 size = content->size();
+    const uchar *data = reinterpret_cast<const uchar *>(content->constData());
+
+    TarDescReader reader([this, &repo](QByteArrayView desc) { addPackage(desc, repo); });
+
+    // repo-add writes gzip-compressed tar files
+    if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+        z_stream stream = {};
+        if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK)
+            return false;
+        stream.next_in = const_cast<Bytef *>(data);
+        stream.avail_in = uInt(size);
+
+        QByteArray chunk(kInflateChunk, Qt::Uninitialized);
+        int ret = Z_OK;
+        while (ret == Z_OK) {
+            stream.next_out = reinterpret_cast<Bytef *>(chunk.data());
+            stream.avail_out = uInt(chunk.size());
+            ret = inflate(&stream, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END)
+                break;
+            reader.feed(chunk.constData(), chunk.size() - qsizetype(stream.avail_out));
+            // All input consumed without reaching the end: truncated file
+            if (ret == Z_OK && stream.avail_in == 0 && stream.avail_out != 0)
+                break;
+        }
+        inflateEnd(&stream);
+
+        if (ret != Z_STREAM_END) {
+            qWarning() << "Corrupt or truncated sync database" << path;
+            return false;
+        }
+        return true;
+    }
+
+    if (size > 262 && std::memcmp(data + 257, "ustar", 5) == 0) {
+        reader.feed(reinterpret_cast<const char *>(data), qsizetype(size));
+        return true;
+    }
+
+    qWarning() << "Unsupported sync database format" << path << "- only gzip or plain tar is read";
+    return false;
+}
+
+void SyncDbIndex::addPackage(QByteArrayView desc, const QString &repo)
+{
+    SyncPackage package;
+    package.repo = repo;
+
+    // "%NAME%\nnvidia-utils\n\n%VERSION%\n550.78-1\n\n..."
+    QByteArrayView section;
+    qsizetype pos = 0;
+    while (pos < desc.size()) {
+        const char *newline = static_cast<const char *>(
+            std::memchr(desc.data() + pos, '\n', size_t(desc.size() - pos)));
+        const qsizetype end = newline ? newline - desc.data() : desc.size();
+        const QByteArrayView line = desc.sliced(pos, end - pos);
+        pos = end + 1;
+
+        if (line.isEmpty()) {
+            section = {};
+        } else if (line.startsWith('%') && line.endsWith('%')) {
+            section = line;
+        } else if (section == QByteArrayView("%NAME%")) {
+            package.name = QString::fromUtf8(line);
+        } else if (section == QByteArrayView("%VERSION%")) {
+            package.version = QString::fromUtf8(line);
+        } else if (section == QByteArrayView("%DESC%")) {
+            package.description = QString::fromUtf8(line);
+        } else if (section == QByteArrayView("%PROVIDES%")) {
+            const qsizetype eq = line.indexOf('=');
+            package.provides.append(QString::fromUtf8(eq < 0 ? line : line.first(eq)));
+        }
+    }
+
+    if (!package.name.isEmpty())
+        m_packages.append(package);
+}
+
+void SyncDbIndex::buildLookupTables()
+{
+    m_byName.resize(m_packages.size());
+    std::iota(m_byName.begin(), m_byName.end(), 0u);
+    std::sort(m_byName.begin(), m_byName.end(), [this](quint32 a, quint32 b) {
+        return m_packages.at(a).name.compare(m_packages.at(b).name, Qt::CaseInsensitive) < 0;
+    });
+
+    // (trigram << 32 | package) pairs, sorted, give the posting lists
+    std::vector<quint64> pairs;
+    for (qsizetype i = 0; i < m_packages.size(); ++i) {
+        for (const quint32 gram : trigrams(searchText(m_packages.at(i))))
+            pairs.push_back(quint64(gram) << 32 | quint64(i));
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    m_postings.reserve(qsizetype(pairs.size()));
+    for (const quint64 pair : pairs) {
+        const quint32 gram = quint32(pair >> 32);
+        if (m_trigramKeys.isEmpty() || m_trigramKeys.last() != gram) {
+            m_trigramKeys.append(gram);
+            m_trigramStart.append(quint32(m_postings.size()));
+        }
+        m_postings.append(quint32(pair));
+    }
+    m_trigramStart.append(quint32(m_postings.size()));
+}
+
+QList<quint32> SyncDbIndex::trigramCandidates(const QByteArray &query) const
+{
+    // Posting ranges of every trigram, shortest first
+    QList<QPair<quint32, quint32>> ranges;
+    for (const quint32 gram : trigrams(query)) {
+        const auto it = std::lower_bound(m_trigramKeys.cbegin(), m_trigramKeys.cend(), gram);
+        if (it == m_trigramKeys.cend() || *it != gram)
+            return {};
+        const qsizetype k = it - m_trigramKeys.cbegin();
+        ranges.append({m_trigramStart.at(k), m_trigramStart.at(k + 1)});
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const auto &a, const auto &b) {
+        return a.second - a.first < b.second - b.first;
+    });
+
+    QList<quint32> result(m_postings.cbegin() + ranges.first().first,
+                          m_postings.cbegin() + ranges.first().second);
+    QList<quint32> intersection;
+    for (qsizetype r = 1; r < ranges.size() && !result.isEmpty(); ++r) {
+        intersection.clear();
+        std::set_intersection(result.cbegin(), result.cend(),
+                              m_postings.cbegin() + ranges.at(r).first,
+                              m_postings.cbegin() + ranges.at(r).second,
+                              std::back_inserter(intersection));
+        result.swap(intersection);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// On-disk cache
+// ---------------------------------------------------------------------------
+
+bool SyncDbIndex::loadCache(const QByteArray &key)
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray cachedKey;
+    quint32 count = 0;
+    in >> magic >> version;
+    if (magic != kCacheMagic || version != kCacheVersion)
+        return false;
+    in >> cachedKey;
+    if (cachedKey != key)
+        return false;
+
+    // Every package takes at least five length fields; a count the rest of
+    // the file cannot hold means the cache is damaged
+    in >> count;
+    if (in.status() != QDataStream::Ok
+        || qint64(count) * 5 * qint64(sizeof(quint32)) > file.size() - file.pos()) {
+        qWarning() << "Discarding damaged sync database index" << file.fileName();
+        return false;
+    }
+    m_packages.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        SyncPackage package;
+        in >> package.repo >> package.name >> package.version >> package.description >> package.provides;
+        m_packages.append(package);
+    }
+
+    const qint64 size = file.size();
+    if (in.status() != QDataStream::Ok
+        || !readTable(in, m_byName, size) || !readTable(in, m_trigramKeys, size)
+        || !readTable(in, m_trigramStart, size) || !readTable(in, m_postings, size)
+        || m_byName.size() != m_packages.size()
+        || m_trigramStart.size() != m_trigramKeys.size() + 1
+        || !rangesWithin(m_trigramStart, m_postings.size())
+        || !indexesWithin(m_postings, m_packages.size())
+        || !indexesWithin(m_byName, m_packages.size())) {
+        qWarning() << "Discarding damaged sync database index" << file.fileName();
+        invalidate();
+        return false;
+    }
+    return true;
+}
+
+void SyncDbIndex::saveCache(const QByteArray &key) const
+{
+    const QString path = cachePath();
+    QDir().mkpath(QFileInfo(path).path());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write sync database index" << path;
+        return;
+    }
+
+    QDataStream out(&file);
+    out << kCacheMagic << kCacheVersion << key << quint32(m_packages.size());
+    for (const SyncPackage &package : m_packages)
+        out << package.repo << package.name << package.version << package.description << package.provides;
+    writeTable(out, m_byName);
+    writeTable(out, m_trigramKeys);
+    writeTable(out, m_trigramStart);
+    writeTable(out, m_postings);
+
+    if (!file.commit())
+        qWarning() << "Failed to write sync database index" << path;
+}
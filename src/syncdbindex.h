@@ -0,0 +1,99 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SYNCDBINDEX_H
+#define SYNCDBINDEX_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/// A package in the sync databases
+struct SyncPackage {
+    QString repo;          // "core", "extra", ...
+    QString name;
+    QString version;
+    QString description;
+    QStringList provides;  // names only, version constraints stripped
+};
+
+/// In-process equivalent of `pacman -Ss`, built from the sync databases
+/// (/var/lib/pacman/sync/*.db).
+///
+/// Names, provides and descriptions are indexed by lowercase trigram, and
+/// names additionally in sorted order for prefix lookups, so a search only
+/// looks at the packages containing every trigram of the query. Building
+/// the index inflates and walks each tar database once; the result is
+/// cached in ~/.cache/rscn-drivers/syncdb.idx and reused until the mtime of
+/// a database changes, i.e. after the next `pacman -Sy`. The databases are
+/// read through SystemAccess, so a replayed search sees the recorded repos.
+class SyncDbIndex
+{
+public:
+    explicit SyncDbIndex(const QString &syncDbPath = QStringLiteral("/var/lib/pacman/sync"));
+
+    /// Packages whose name, provides or description contain the query,
+    /// case-insensitively. Name matches come first (exact, prefix, then
+    /// anywhere), then provides, then description matches.
+    QList<SyncPackage> search(const QString &query, int limit = -1);
+
+    /// Packages whose name starts with prefix, in name order
+    QList<SyncPackage> withPrefix(const QString &prefix, int limit = -1);
+
+    /// Drop the index; it is reloaded or rebuilt on the next lookup
+    void invalidate();
+
+    /// Number of packages currently indexed
+    qsizetype size() const { return m_packages.size(); }
+
+    /// Location of the on-disk cache
+    static QString cachePath();
+
+private:
+    /// Load or rebuild the index if the databases changed since
+    void ensureCurrent();
+
+    /// File names of the sync databases, sorted
+    QStringList databaseNames() const;
+
+    /// Name and mtime of every database; identifies what the index was
+    /// built from
+    QByteArray inputsKey() const;
+
+    /// Parse every database and build the trigram and name indexes
+    void build();
+
+    /// Add the packages of one (gzip-compressed or plain) tar database
+    bool readDatabase(const QString &path, const QString &repo);
+
+    /// Add one package from the contents of its `desc` member
+    void addPackage(QByteArrayView desc, const QString &repo);
+
+    void buildLookupTables();
+
+    bool loadCache(const QByteArray &key);
+    void saveCache(const QByteArray &key) const;
+
+    /// Indexes of packages containing every trigram of a lowercase query
+    QList<quint32> trigramCandidates(const QByteArray &query) const;
+
+    QString m_syncDbPath;
+    QList<SyncPackage> m_packages;
+    QList<quint32> m_byName;         // package indexes in lowercase name order
+    QList<quint32> m_trigramKeys;    // sorted distinct trigrams
+    QList<quint32> m_trigramStart;   // postings of key i: [start[i], start[i+1])
+    QList<quint32> m_postings;       // package indexes, ascending per trigram
+    QByteArray m_builtFor;           // inputsKey() the index reflects
+    bool m_built = false;
+};
+
+#endif // SYNCDBINDEX_H
@@ -0,0 +1,393 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "systemaccess.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QSaveFile>
+#include <QThread>
+
+SystemAccess &SystemAccess::instance()
+{
+    static SystemAccess access;
+    return access;
+}
+
+SystemAccess::SystemAccess()
+{
+    const QString mode = qEnvironmentVariable("RSCN_SYSTEM_ACCESS");
+    m_bundlePath = qEnvironmentVariable("RSCN_SYSTEM_BUNDLE");
+
+    if (mode == "record" || mode == "replay") {
+        if (m_bundlePath.isEmpty()) {
+            qWarning() << "RSCN_SYSTEM_ACCESS is set but RSCN_SYSTEM_BUNDLE is not; using the live system";
+            return;
+        }
+        m_mode = (mode == "record") ? Mode::Record : Mode::Replay;
+    } else if (!mode.isEmpty() && mode != "live") {
+        qWarning() << "Unknown RSCN_SYSTEM_ACCESS mode" << mode << "- using the live system";
+        return;
+    }
+
+    const QString latency = qEnvironmentVariable("RSCN_REPLAY_LATENCY");
+    if (latency == "recorded")
+        m_replayRecordedLatency = true;
+    else
+        m_replayFixedLatencyMs = qMax(0LL, latency.toLongLong());
+
+    if (m_mode == Mode::Record) {
+        QDir().mkpath(m_bundlePath);
+        // Extend an existing bundle rather than dropping its fixtures
+        loadBundle();
+        qDebug() << "Recording system access to" << m_bundlePath;
+    } else if (m_mode == Mode::Replay) {
+        loadBundle();
+        qDebug() << "Replaying system access from" << m_bundlePath
+                 << "(" << m_entries.size() << "entries )";
+    }
+}
+
+SystemAccess::~SystemAccess()
+{
+    flush();
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void SystemAccess::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_mode != Mode::Record || !m_dirty)
+        return;
+    saveIndex();
+    m_dirty = false;
+}
+
+CommandResult SystemAccess::run(const QString &program, const QStringList &args, int timeoutMs)
+{
+    if (m_mode == Mode::Replay) {
+        std::optional<CommandResult> result = recordedCommand(program, args);
+        if (!result)
+            return {};
+        const qint64 delay = replayLatencyMs(*result);
+        if (delay > 0)
+            QThread::msleep(static_cast<unsigned long>(delay));
+        return *result;
+    }
+
+    const CommandResult result = runLive(program, args, timeoutMs);
+    recordCommand(program, args, result);
+    return result;
+}
+
+std::optional<QByteArray> SystemAccess::readFile(const QString &path)
+{
+    const QString key = entryKey("read", path);
+    if (m_mode == Mode::Replay) {
+        QByteArray data;
+        std::optional<Entry> entry = lookup(key, &data);
+        if (!entry || entry->exitCode != 0)
+            return std::nullopt;
+        return data;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(path);
+    std::optional<QByteArray> data;
+    if (file.open(QIODevice::ReadOnly))
+        data = file.readAll();
+
+    if (m_mode == Mode::Record) {
+        Entry entry;
+        entry.kind = "read";
+        entry.subject = path;
+        entry.exitCode = data ? 0 : -1;
+        entry.durationMs = timer.elapsed();
+        record(entry, data.value_or(QByteArray()));
+    }
+    return data;
+}
+
+bool SystemAccess::exists(const QString &path)
+{
+    const QString key = entryKey("exists", path);
+    if (m_mode == Mode::Replay) {
+        std::optional<Entry> entry = lookup(key, nullptr);
+        return entry && entry->exitCode == 0;
+    }
+
+    const bool present = QFileInfo::exists(path);
+    if (m_mode == Mode::Record) {
+        Entry entry;
+        entry.kind = "exists";
+        entry.subject = path;
+        entry.exitCode = present ? 0 : -1;
+        record(entry, {});
+    }
+    return present;
+}
+
+QStringList SystemAccess::entryList(const QString &directory)
+{
+    const QString key = entryKey("list", directory);
+    if (m_mode == Mode::Replay) {
+        QByteArray data;
+        std::optional<Entry> entry = lookup(key, &data);
+        if (!entry || entry->exitCode != 0)
+            return {};
+        return QString::fromUtf8(data).split('\n', Qt::SkipEmptyParts);
+    }
+
+    const QDir dir(directory);
+    const QStringList names = dir.exists()
+        ? dir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System, QDir::Name)
+        : QStringList();
+
+    if (m_mode == Mode::Record) {
+        Entry entry;
+        entry.kind = "list";
+        entry.subject = directory;
+        entry.exitCode = dir.exists() ? 0 : -1;
+        record(entry, names.join('\n').toUtf8());
+    }
+    return names;
+}
+
+QDateTime SystemAccess::lastModified(const QString &path)
+{
+    const QString key = entryKey("mtime", path);
+    if (m_mode == Mode::Replay) {
+        QByteArray data;
+        std::optional<Entry> entry = lookup(key, &data);
+        if (!entry || entry->exitCode != 0)
+            return {};
+        return QDateTime::fromMSecsSinceEpoch(data.toLongLong());
+    }
+
+    const QFileInfo info(path);
+    const QDateTime modified = info.exists() ? info.lastModified() : QDateTime();
+    if (m_mode == Mode::Record) {
+        Entry entry;
+        entry.kind = "mtime";
+        entry.subject = path;
+        entry.exitCode = modified.isValid() ? 0 : -1;
+        record(entry, modified.isValid() ? QByteArray::number(modified.toMSecsSinceEpoch()) : QByteArray());
+    }
+    return modified;
+}
+
+QString SystemAccess::canonicalPath(const QString &path)
+{
+    const QString key = entryKey("resolve", path);
+    if (m_mode == Mode::Replay) {
+        QByteArray data;
+        std::optional<Entry> entry = lookup(key, &data);
+        if (!entry || entry->exitCode != 0)
+            return {};
+        return QString::fromUtf8(data);
+    }
+
+    const QString resolved = QFileInfo(path).canonicalFilePath();
+    if (m_mode == Mode::Record) {
+        Entry entry;
+        entry.kind = "resolve";
+        entry.subject = path;
+        entry.exitCode = resolved.isEmpty() ? -1 : 0;
+        record(entry, resolved.toUtf8());
+    }
+    return resolved;
+}
+
+void SystemAccess::recordCommand(const QString &program, const QStringList &args, const CommandResult &result)
+{
+    if (m_mode != Mode::Record)
+        return;
+
+    Entry entry;
+    entry.kind = "run";
+    entry.subject = program;
+    entry.args = args;
+    entry.exitCode = result.exitCode;
+    entry.durationMs = result.durationMs;
+    record(entry, result.output);
+}
+
+std::optional<CommandResult> SystemAccess::recordedCommand(const QString &program, const QStringList &args)
+{
+    QByteArray data;
+    std::optional<Entry> entry = lookup(entryKey("run", program, args), &data);
+    if (!entry)
+        return std::nullopt;
+
+    CommandResult result;
+    result.output = data;
+    result.exitCode = entry->exitCode;
+    result.durationMs = entry->durationMs;
+    return result;
+}
+
+qint64 SystemAccess::replayLatencyMs(const CommandResult &result) const
+{
+    return m_replayRecordedLatency ? result.durationMs : m_replayFixedLatencyMs;
+}
+
+// ---------------------------------------------------------------------------
+// Bundle storage
+// ---------------------------------------------------------------------------
+
+QString SystemAccess::entryKey(const QString &kind, const QString &subject, const QStringList &args)
+{
+    QString key = kind + QLatin1Char('\x1f') + subject;
+    for (const QString &arg : args)
+        key += QLatin1Char('\x1f') + arg;
+    return key;
+}
+
+std::optional<SystemAccess::Entry> SystemAccess::lookup(const QString &key, QByteArray *data)
+{
+    Entry entry;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(key);
+        if (it == m_entries.constEnd()) {
+            qWarning().noquote() << "No recorded result for" << QString(key).replace(QLatin1Char('\x1f'), ' ');
+            return std::nullopt;
+        }
+        entry = it.value();
+    }
+
+    if (data && !entry.blob.isEmpty()) {
+        QFile blob(QDir(m_bundlePath).filePath(entry.blob));
+        if (!blob.open(QIODevice::ReadOnly)) {
+            qWarning() << "Missing fixture blob" << blob.fileName();
+            return std::nullopt;
+        }
+        *data = blob.readAll();
+    }
+    return entry;
+}
+
+void SystemAccess::record(Entry entry, const QByteArray &data)
+{
+    if (!data.isEmpty()) {
+        // Identical outputs (e.g. repeated pacman -Q misses) share one blob
+        entry.blob = QString::fromLatin1(
+            QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex()) + ".bin";
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!entry.blob.isEmpty()) {
+        const QString blobPath = QDir(m_bundlePath).filePath(entry.blob);
+        if (!QFileInfo::exists(blobPath)) {
+            QSaveFile blob(blobPath);
+            if (!blob.open(QIODevice::WriteOnly) || blob.write(data) != data.size() || !blob.commit())
+                qWarning() << "Failed to write fixture blob" << blobPath;
+        }
+    }
+
+    // Blobs are written right away, the index once at the end (flush());
+    // rewriting it per entry made recording quadratic in the bundle size
+    m_entries.insert(entryKey(entry.kind, entry.subject, entry.args), entry);
+    m_dirty = true;
+}
+
+void SystemAccess::loadBundle()
+{
+    QFile file(QDir(m_bundlePath).filePath("index.json"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (m_mode == Mode::Replay)
+            qWarning() << "Cannot open fixture index" << file.fileName();
+        return;
+    }
+
+    const QJsonArray entries = QJsonDocument::fromJson(file.readAll()).object().value("entries").toArray();
+    for (const QJsonValue &value : entries) {
+        const QJsonObject obj = value.toObject();
+        Entry entry;
+        entry.kind = obj.value("kind").toString();
+        entry.subject = obj.value("subject").toString();
+        for (const QJsonValue &arg : obj.value("args").toArray())
+            entry.args.append(arg.toString());
+        entry.blob = obj.value("blob").toString();
+        entry.exitCode = obj.value("exitCode").toInt(-1);
+        entry.durationMs = obj.value("durationMs").toInteger();
+        m_entries.insert(entryKey(entry.kind, entry.subject, entry.args), entry);
+    }
+}
+
+void SystemAccess::saveIndex()
+{
+    QJsonArray entries;
+    for (const Entry &entry : std::as_const(m_entries)) {
+        QJsonObject obj;
+        obj["kind"] = entry.kind;
+        obj["subject"] = entry.subject;
+        if (!entry.args.isEmpty())
+            obj["args"] = QJsonArray::fromStringList(entry.args);
+        if (!entry.blob.isEmpty())
+            obj["blob"] = entry.blob;
+        obj["exitCode"] = entry.exitCode;
+        obj["durationMs"] = entry.durationMs;
+        entries.append(obj);
+    }
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["entries"] = entries;
+
+    QSaveFile file(QDir(m_bundlePath).filePath("index.json"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write fixture index" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    if (!file.commit())
+        qWarning() << "Failed to write fixture index" << file.fileName();
+}
+
+// ---------------------------------------------------------------------------
+// Live execution
+// ---------------------------------------------------------------------------
+
+CommandResult SystemAccess::runLive(const QString &program, const QStringList &args, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(program, args);
+
+    CommandResult result;
+    if (!process.waitForFinished(timeoutMs) && process.state() != QProcess::NotRunning) {
+        process.kill();
+        process.waitForFinished(1000);
+    }
+    result.output = process.readAllStandardOutput();
+    if (process.exitStatus() == QProcess::NormalExit && process.error() != QProcess::FailedToStart)
+        result.exitCode = process.exitCode();
+    result.durationMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,126 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SYSTEMACCESS_H
+#define SYSTEMACCESS_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+/// Result of a command run through SystemAccess
+struct CommandResult {
+    QByteArray output;     // stdout and stderr, merged
+    int exitCode = -1;     // -1 if the command did not start, crashed or timed out
+    qint64 durationMs = 0; // wall-clock time of the (recorded) run
+};
+
+/// Single gateway for what the scan and switch pipelines read from the
+/// system: command output, file contents, path existence, modification
+/// times, resolved paths and directory listings.
+///
+/// The mode is chosen once from the environment:
+///   RSCN_SYSTEM_ACCESS=record   run against the live system and capture
+///                               every result into RSCN_SYSTEM_BUNDLE
+///   RSCN_SYSTEM_ACCESS=replay   serve results from RSCN_SYSTEM_BUNDLE only;
+///                               nothing is executed or read from the system
+///   RSCN_REPLAY_LATENCY         "recorded" to delay each replayed command by
+///                               its recorded duration, or a fixed delay in
+///                               milliseconds (default 0)
+///
+/// A bundle is a directory holding index.json plus one blob per distinct
+/// output, named by its SHA-1, so fixtures can be copied and diffed. Blobs
+/// are written as they are recorded, index.json when the process exits.
+class SystemAccess
+{
+public:
+    enum class Mode {
+        Live,
+        Record,
+        Replay
+    };
+
+    static SystemAccess &instance();
+    ~SystemAccess();
+
+    Mode mode() const { return m_mode; }
+
+    /// Write index.json if anything was recorded since the last flush.
+    /// Runs at exit; the application also calls it when it quits.
+    void flush();
+
+    /// Run a command to completion and return its merged output
+    CommandResult run(const QString &program, const QStringList &args, int timeoutMs = 10000);
+
+    /// Contents of a file, or empty if it cannot be read
+    std::optional<QByteArray> readFile(const QString &path);
+
+    /// Whether a path exists
+    bool exists(const QString &path);
+
+    /// Names in a directory (without "." and ".."), sorted
+    QStringList entryList(const QString &directory);
+
+    /// Modification time of a path; invalid if it does not exist
+    QDateTime lastModified(const QString &path);
+
+    /// Path with symlinks resolved (QFileInfo::canonicalFilePath), or empty
+    /// if it does not exist
+    QString canonicalPath(const QString &path);
+
+    /// Capture the result of an operation that was run asynchronously
+    /// outside run(); does nothing unless recording
+    void recordCommand(const QString &program, const QStringList &args, const CommandResult &result);
+
+    /// Recorded result of a command, without delay; replay mode only
+    std::optional<CommandResult> recordedCommand(const QString &program, const QStringList &args);
+
+    /// Delay to apply before delivering a replayed command result
+    qint64 replayLatencyMs(const CommandResult &result) const;
+
+private:
+    SystemAccess();
+
+    struct Entry {
+        QString kind;        // "run", "read", "exists", "list", "mtime" or "resolve"
+        QString subject;     // program or path
+        QStringList args;    // command arguments ("run" only)
+        QString blob;        // blob file name, empty if there is no data
+        int exitCode = -1;   // "run": exit code; others: 0 = present, -1 = missing
+        qint64 durationMs = 0;
+    };
+
+    static QString entryKey(const QString &kind, const QString &subject, const QStringList &args = {});
+
+    /// Look up an entry and load its blob; logs a warning on a miss
+    std::optional<Entry> lookup(const QString &key, QByteArray *data);
+
+    void record(Entry entry, const QByteArray &data);
+    void loadBundle();
+    void saveIndex();
+
+    static CommandResult runLive(const QString &program, const QStringList &args, int timeoutMs);
+
+    Mode m_mode = Mode::Live;
+    QString m_bundlePath;
+    bool m_replayRecordedLatency = false;
+    qint64 m_replayFixedLatencyMs = 0;
+
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    bool m_dirty = false;   // entries recorded but not yet in index.json
+};
+
+#endif // SYSTEMACCESS_H
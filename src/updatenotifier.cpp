@@ -0,0 +1,256 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "updatenotifier.h"
+#include "driverprofile.h"
+#include "hardwaredetector.h"
+#include "packagemanager.h"
+#include "systemaccess.h"
+#include "vercmp.h"
+
+#include <QDebug>
+#include <QProcess>
+#include <QTimer>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+
+/// Pacman touches the database in bursts; act once it has settled
+constexpr int kSettleMs = 1500;
+
+} // namespace
+
+UpdateNotifier::UpdateNotifier(const QString &dbPath, QObject *parent)
+    : QObject(parent)
+    , m_dbPath(dbPath)
+    , m_settleTimer(new QTimer(this))
+{
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(kSettleMs);
+    connect(m_settleTimer, &QTimer::timeout, this, &UpdateNotifier::check);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &UpdateNotifier::onDirectoryChanged);
+}
+
+UpdateNotifier::~UpdateNotifier()
+{
+    if (m_notification)
+        m_notification->kill();
+}
+
+bool UpdateNotifier::start()
+{
+    // The database root is watched for db.lck coming and going; sync DBs
+    // are replaced by rename and local entries added and removed, so the
+    // directories themselves are enough
+    const QStringList paths = {m_dbPath, m_dbPath + "/sync", m_dbPath + "/local"};
+    const QStringList failed = m_watcher.addPaths(paths);
+    if (failed.contains(m_dbPath) || failed.contains(m_dbPath + "/local")) {
+        qWarning() << "Cannot watch the pacman database in" << m_dbPath;
+        return false;
+    }
+
+    check();
+    return true;
+}
+
+void UpdateNotifier::onDirectoryChanged(const QString &path)
+{
+    if (path.endsWith("/sync"))
+        m_syncChanged = true;
+    else if (path.endsWith("/local"))
+        m_localChanged = true;
+    m_settleTimer->start();
+}
+
+void UpdateNotifier::check()
+{
+    // Mid-transaction: the removal of the lock brings us back here
+    if (SystemAccess::instance().exists(m_dbPath + "/db.lck"))
+        return;
+
+    QStringList lines;
+    // A transaction can change both the installed versions and the
+    // recommendation, so local changes re-check updates as well
+    if (m_syncChanged || m_localChanged)
+        lines << driverUpdates();
+    if (m_localChanged)
+        lines << profileChanges();
+    m_syncChanged = false;
+    m_localChanged = false;
+
+    if (!lines.isEmpty())
+        notify(tr("Driver updates available"), lines);
+}
+
+// ---------------------------------------------------------------------------
+// Package versions
+// ---------------------------------------------------------------------------
+
+QHash<QString, QString> UpdateNotifier::localVersions() const
+{
+    QHash<QString, QString> versions;
+    for (const QString &entry : SystemAccess::instance().entryList(m_dbPath + "/local")) {
+        // "<name>-<pkgver>-<pkgrel>"; names may contain dashes, versions not
+        const qsizetype relDash = entry.lastIndexOf('-');
+        if (relDash <= 0)
+            continue;
+        const qsizetype verDash = entry.lastIndexOf('-', relDash - 1);
+        if (verDash <= 0)
+            continue;
+        versions.insert(entry.left(verDash), entry.mid(verDash + 1));
+    }
+    return versions;
+}
+
+QHash<QString, QString> UpdateNotifier::syncVersions(const QStringList &packages) const
+{
+    QHash<QString, QString> versions;
+    if (packages.isEmpty())
+        return versions;
+
+    // Fails as a whole if one package is missing, but still prints the rest
+    const CommandResult result = SystemAccess::instance().run("pacman", QStringList() << "-Si" << packages, 10000);
+
+    QString name;
+    for (const QByteArray &rawLine : result.output.split('\n')) {
+        const qsizetype colon = rawLine.indexOf(':');
+        if (colon < 0)
+            continue;
+        const QByteArray key = rawLine.first(colon).trimmed();
+        const QString value = QString::fromUtf8(rawLine.sliced(colon + 1).trimmed());
+        if (key == "Name") {
+            name = value;
+        } else if (key == "Version" && !name.isEmpty()) {
+            // The first repository listing a package is the one pacman uses
+            if (!versions.contains(name))
+                versions.insert(name, value);
+            name.clear();
+        }
+    }
+    return versions;
+}
+
+QStringList UpdateNotifier::driverUpdates()
+{
+    const QHash<QString, QString> installed = localVersions();
+
+    QStringList driverPackages;
+    for (const DriverProfile &profile : DriverProfileManager::getAllProfiles()) {
+        for (const QString &pkg : profile.requiredPackages + profile.optionalPackages) {
+            if (installed.contains(pkg) && !driverPackages.contains(pkg))
+                driverPackages.append(pkg);
+        }
+    }
+
+    const QHash<QString, QString> available = syncVersions(driverPackages);
+
+    QStringList updates;
+    for (const QString &pkg : std::as_const(driverPackages)) {
+        const QString current = installed.value(pkg);
+        const QString candidate = available.value(pkg);
+        if (candidate.isEmpty() || vercmp(candidate, current) <= 0)
+            continue;
+
+        const QString key = pkg + ' ' + candidate;
+        if (m_reportedUpdates.contains(key))
+            continue;
+        m_reportedUpdates.insert(key);
+        updates << QString("%1 %2 → %3").arg(pkg, current, candidate);
+    }
+    return updates;
+}
+
+// ---------------------------------------------------------------------------
+// Profile recommendations
+// ---------------------------------------------------------------------------
+
+QStringList UpdateNotifier::profileChanges()
+{
+    QStringList changes;
+    {
+        // The profile checks build the whole-system file ownership and sync
+        // database indexes; they only live for this check, so the resident
+        // notifier stays small between transactions
+        HardwareDetector detector;
+        PackageManager packageManager;
+        changes = profileChanges(detector, packageManager);
+    }
+#ifdef __GLIBC__
+    // The indexes are many small allocations; hand the freed heap back
+    malloc_trim(0);
+#endif
+    return changes;
+}
+
+QStringList UpdateNotifier::profileChanges(HardwareDetector &detector, PackageManager &packageManager)
+{
+    QStringList changes;
+    for (const GpuDevice &gpu : detector.detectGpus()) {
+        const QList<DriverProfile> profiles =
+            DriverProfileManager::getProfilesForDevice(gpu, packageManager);
+
+        const DriverProfile *recommended = nullptr;
+        const DriverProfile *active = nullptr;
+        for (const DriverProfile &profile : profiles) {
+            if (profile.recommended)
+                recommended = &profile;
+            if (profile.active)
+                active = &profile;
+        }
+        if (!recommended || recommended->active)
+            continue;
+        if (m_reportedProfile.value(gpu.pciSlot) == recommended->id)
+            continue;
+
+        m_reportedProfile.insert(gpu.pciSlot, recommended->id);
+        changes << tr("%1 %2: %3 is recommended (in use: %4)")
+                       .arg(gpu.vendor, gpu.model, recommended->displayName,
+                            active ? active->displayName : tr("none"));
+    }
+    return changes;
+}
+
+// ---------------------------------------------------------------------------
+// Notifications
+// ---------------------------------------------------------------------------
+
+void UpdateNotifier::notify(const QString &summary, const QStringList &lines)
+{
+    // One notification at a time; a newer one replaces it
+    if (m_notification) {
+        m_notification->disconnect(this);
+        m_notification->kill();
+        m_notification->deleteLater();
+    }
+
+    m_notification = new QProcess(this);
+    QProcess *process = m_notification;
+    connect(process, &QProcess::finished, this, [this, process]() {
+        // --wait prints the name of the invoked action
+        if (process->readAllStandardOutput().trimmed() == "open")
+            QProcess::startDetached("rscn-drivers", {});
+        process->deleteLater();
+        if (m_notification == process)
+            m_notification = nullptr;
+    });
+
+    process->start("notify-send", {
+        "--app-name=" + tr("RSCN Drivers"),
+        "--icon=rscn-drivers",
+        "--action=open=" + tr("Open Driver Manager"),
+        "--wait",
+        summary,
+        lines.join('\n')
+    });
+}
@@ -0,0 +1,85 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef UPDATENOTIFIER_H
+#define UPDATENOTIFIER_H
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class HardwareDetector;
+class PackageManager;
+class QProcess;
+class QTimer;
+
+/// Background notifier for driver updates, run as rscn-drivers-notifier.
+///
+/// Sleeps on inotify watches of the pacman database (via
+/// QFileSystemWatcher) and never polls: a change to the sync databases
+/// (after `pacman -Sy`) triggers a check for newer versions of installed
+/// driver packages, a change to the local database (after a transaction)
+/// re-runs the profile recommendation for the detected GPUs. Versions are
+/// compared in-process with vercmp(). Findings are shown with notify-send;
+/// the GUI is only started if the user clicks the notification action.
+class UpdateNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateNotifier(const QString &dbPath = QStringLiteral("/var/lib/pacman"),
+                            QObject *parent = nullptr);
+    ~UpdateNotifier();
+
+    /// Install the watches and run an initial check; false if the database
+    /// directory cannot be watched
+    bool start();
+
+private slots:
+    void onDirectoryChanged(const QString &path);
+
+    /// Run the checks for whatever changed since the last one
+    void check();
+
+private:
+    /// Installed package versions from the local DB directory names
+    /// ("<name>-<version>-<release>"), without running pacman
+    QHash<QString, QString> localVersions() const;
+
+    /// Repository versions of the given packages (one `pacman -Si`)
+    QHash<QString, QString> syncVersions(const QStringList &packages) const;
+
+    /// "<package> <installed> → <available>" for each outdated driver package
+    QStringList driverUpdates();
+
+    /// Recommended profiles that differ from the one in use, not yet
+    /// reported; detection state is created for the check and dropped after
+    QStringList profileChanges();
+    QStringList profileChanges(HardwareDetector &detector, PackageManager &packageManager);
+
+    /// Show a notification with an action that opens the driver manager
+    void notify(const QString &summary, const QStringList &lines);
+
+    QString m_dbPath;
+    QFileSystemWatcher m_watcher;
+    QTimer *m_settleTimer = nullptr;
+    bool m_syncChanged = true;
+    bool m_localChanged = true;
+
+    QSet<QString> m_reportedUpdates;          // "<package> <version>" already notified
+    QHash<QString, QString> m_reportedProfile; // PCI slot -> recommended profile id notified
+
+    QProcess *m_notification = nullptr;
+};
+
+#endif // UPDATENOTIFIER_H
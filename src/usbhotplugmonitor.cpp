@@ -0,0 +1,139 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "usbhotplugmonitor.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+/// Multicast group of raw kernel uevents (udev rebroadcasts on group 2)
+constexpr unsigned kKernelUeventGroup = 1;
+
+/// How long to collect related events before reporting them
+constexpr int kCoalesceMs = 250;
+
+} // namespace
+
+UsbHotplugMonitor::UsbHotplugMonitor(QObject *parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kCoalesceMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &UsbHotplugMonitor::flush);
+}
+
+UsbHotplugMonitor::~UsbHotplugMonitor()
+{
+    if (m_socket >= 0)
+        ::close(m_socket);
+}
+
+bool UsbHotplugMonitor::start()
+{
+    if (m_socket >= 0)
+        return true;
+
+    const int fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        qWarning() << "Cannot open uevent socket:" << std::strerror(errno);
+        return false;
+    }
+
+    sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = kKernelUeventGroup;
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        qWarning() << "Cannot bind uevent socket:" << std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    m_socket = fd;
+    m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UsbHotplugMonitor::readEvents);
+    return true;
+}
+
+void UsbHotplugMonitor::readEvents()
+{
+    char buffer[8192];
+    for (;;) {
+        const ssize_t received = ::recv(m_socket, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            break;
+        handleEvent(QByteArray(buffer, qsizetype(received)));
+    }
+}
+
+void UsbHotplugMonitor::handleEvent(const QByteArray &message)
+{
+    // "<action>@<devpath>\0KEY=value\0KEY=value\0..."
+    QByteArray action;
+    QByteArray devpath;
+    QByteArray subsystem;
+    QByteArray devtype;
+    for (const QByteArray &field : message.split('\0')) {
+        if (field.startsWith("ACTION="))
+            action = field.sliced(7);
+        else if (field.startsWith("DEVPATH="))
+            devpath = field.sliced(8);
+        else if (field.startsWith("SUBSYSTEM="))
+            subsystem = field.sliced(10);
+        else if (field.startsWith("DEVTYPE="))
+            devtype = field.sliced(8);
+    }
+    if (subsystem != "usb" || devpath.isEmpty())
+        return;
+
+    // The last path component is the device ("1-2") or one of its
+    // interfaces ("1-2:1.0")
+    QString name = QString::fromLatin1(devpath.sliced(devpath.lastIndexOf('/') + 1));
+    const qsizetype colon = name.indexOf(':');
+    if (colon >= 0)
+        name.truncate(colon);
+    if (name.isEmpty() || !name.at(0).isDigit())
+        return; // root hub
+
+    if (action == "remove" && devtype == "usb_device") {
+        m_changed.remove(name);
+        m_removed.insert(name);
+    } else if (action == "add" || action == "bind" || action == "unbind" || action == "change") {
+        m_removed.remove(name);
+        m_changed.insert(name);
+    } else {
+        return;
+    }
+    m_flushTimer->start();
+}
+
+void UsbHotplugMonitor::flush()
+{
+    if (m_changed.isEmpty() && m_removed.isEmpty())
+        return;
+
+    QStringList changed(m_changed.cbegin(), m_changed.cend());
+    QStringList removed(m_removed.cbegin(), m_removed.cend());
+    changed.sort();
+    removed.sort();
+    m_changed.clear();
+    m_removed.clear();
+    emit devicesChanged(changed, removed);
+}
@@ -0,0 +1,60 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef USBHOTPLUGMONITOR_H
+#define USBHOTPLUGMONITOR_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QSocketNotifier;
+class QTimer;
+
+/// Watches kernel uevents on a netlink socket and reports which USB
+/// devices were plugged in, unplugged, or had a driver bound or unbound.
+///
+/// Only the affected sysfs device names are reported, so listeners can
+/// re-read just those devices instead of rescanning the bus. Events are
+/// coalesced briefly, since one plug-in produces an add for the device and
+/// a bind for each of its interfaces.
+class UsbHotplugMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UsbHotplugMonitor(QObject *parent = nullptr);
+    ~UsbHotplugMonitor();
+
+    /// Open the netlink socket; false if uevents are not available
+    bool start();
+
+signals:
+    /// changed: devices added or rebound, to be re-read;
+    /// removed: devices that are gone
+    void devicesChanged(const QStringList &changed, const QStringList &removed);
+
+private slots:
+    void readEvents();
+    void flush();
+
+private:
+    /// Parse one uevent datagram and queue the device it concerns
+    void handleEvent(const QByteArray &message);
+
+    int m_socket = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QSet<QString> m_changed;
+    QSet<QString> m_removed;
+};
+
+#endif // USBHOTPLUGMONITOR_H
@@ -0,0 +1,156 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "usbidsdatabase.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <cstring>
+
+namespace {
+
+/// Parse 4 hex digits; -1 if any is not a hex digit
+int parseHex4(const char *p)
+{
+    int value = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = p[i];
+        int digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return -1;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+/// "<id>  <name>" at the start of a line; returns the ID or -1
+int entryId(QByteArrayView line)
+{
+    if (line.size() < 7 || line.at(4) != ' ' || line.at(5) != ' ')
+        return -1;
+    return parseHex4(line.data());
+}
+
+} // namespace
+
+UsbIdsDatabase &UsbIdsDatabase::instance()
+{
+    static UsbIdsDatabase database(defaultPath());
+    return database;
+}
+
+QString UsbIdsDatabase::defaultPath()
+{
+    const QString env = qEnvironmentVariable("RSCN_USB_IDS");
+    return env.isEmpty() ? QStringLiteral("/usr/share/hwdata/usb.ids") : env;
+}
+
+UsbIdsDatabase::UsbIdsDatabase(const QString &path)
+    : m_file(path)
+{
+}
+
+bool UsbIdsDatabase::ensureIndexed()
+{
+    if (m_indexed)
+        return !m_data.isEmpty();
+    m_indexed = true;
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open USB ID database" << m_file.fileName();
+        return false;
+    }
+    uchar *mapped = m_file.map(0, m_file.size());
+    if (!mapped) {
+        qWarning() << "Cannot map USB ID database" << m_file.fileName();
+        return false;
+    }
+    m_data = QByteArrayView(reinterpret_cast<const char *>(mapped), m_file.size());
+
+    // Vendor lines are the only unindented lines starting with 4 hex digits
+    // and two spaces; class, language and HID sections never match
+    const char *data = m_data.data();
+    const qsizetype size = m_data.size();
+    qsizetype pos = 0;
+    while (pos < size) {
+        const char *newline = static_cast<const char *>(std::memchr(data + pos, '\n', size_t(size - pos)));
+        const qsizetype end = newline ? newline - data : size;
+        const int id = entryId(QByteArrayView(data + pos, end - pos));
+        if (id >= 0 && !m_vendors.contains(quint16(id)))
+            m_vendors.insert(quint16(id), pos);
+        pos = end + 1;
+    }
+    return true;
+}
+
+QString UsbIdsDatabase::vendorName(const QString &vendorId)
+{
+    bool ok = false;
+    const uint id = vendorId.toUInt(&ok, 16);
+    if (!ok)
+        return {};
+
+    QMutexLocker locker(&m_mutex);
+    if (!ensureIndexed())
+        return {};
+
+    const auto it = m_vendors.constFind(quint16(id));
+    if (it == m_vendors.constEnd())
+        return {};
+
+    const qsizetype start = it.value() + 6;
+    const qsizetype end = m_data.indexOf('\n', start);
+    return QString::fromUtf8(m_data.sliced(start, (end < 0 ? m_data.size() : end) - start).trimmed());
+}
+
+QString UsbIdsDatabase::productName(const QString &vendorId, const QString &productId)
+{
+    bool vendorOk = false;
+    bool productOk = false;
+    const uint vendor = vendorId.toUInt(&vendorOk, 16);
+    const uint product = productId.toUInt(&productOk, 16);
+    if (!vendorOk || !productOk)
+        return {};
+
+    QMutexLocker locker(&m_mutex);
+    if (!ensureIndexed())
+        return {};
+
+    const auto it = m_vendors.constFind(quint16(vendor));
+    if (it == m_vendors.constEnd())
+        return {};
+
+    // Product lines follow their vendor, indented by one tab; interface
+    // lines use two tabs
+    const char *data = m_data.data();
+    const qsizetype size = m_data.size();
+    qsizetype pos = m_data.indexOf('\n', it.value());
+    while (pos >= 0 && ++pos < size) {
+        const char *newline = static_cast<const char *>(std::memchr(data + pos, '\n', size_t(size - pos)));
+        const qsizetype end = newline ? newline - data : size;
+        const QByteArrayView line(data + pos, end - pos);
+
+        if (!line.isEmpty() && line.front() != '\t' && line.front() != '#')
+            break; // next vendor
+        if (line.size() > 1 && line.front() == '\t' && line.at(1) != '\t'
+            && entryId(line.sliced(1)) == int(product)) {
+            return QString::fromUtf8(line.sliced(7).trimmed());
+        }
+        pos = newline ? end : -1;
+    }
+    return {};
+}
@@ -0,0 +1,54 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef USBIDSDATABASE_H
+#define USBIDSDATABASE_H
+
+#include <QByteArrayView>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+/// Vendor and product names from the hwdata usb.ids file, without forking
+/// lsusb.
+///
+/// The file is memory-mapped and indexed lazily on the first lookup: one
+/// memchr pass records the offset of every vendor line, so a lookup only
+/// scans the product lines of one vendor. Names are decoded on demand; the
+/// mapping stays valid for the lifetime of the process.
+class UsbIdsDatabase
+{
+public:
+    static UsbIdsDatabase &instance();
+
+    /// $RSCN_USB_IDS, or /usr/share/hwdata/usb.ids
+    static QString defaultPath();
+
+    /// Vendor name for a 4-digit hex vendor ID, empty if unknown
+    QString vendorName(const QString &vendorId);
+
+    /// Product name for a vendor:product pair, empty if unknown
+    QString productName(const QString &vendorId, const QString &productId);
+
+private:
+    explicit UsbIdsDatabase(const QString &path);
+
+    /// Map the file and index its vendor lines on first use
+    bool ensureIndexed();
+
+    QFile m_file;
+    QByteArrayView m_data;           // mapped file content
+    QHash<quint16, qsizetype> m_vendors; // vendor ID -> offset of its line
+    QMutex m_mutex;
+    bool m_indexed = false;
+};
+
+#endif // USBIDSDATABASE_H
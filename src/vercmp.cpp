@@ -0,0 +1,168 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "vercmp.h"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+bool isDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+bool isAlpha(char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; }
+bool isAlnum(char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; }
+
+/// Compare one part (epoch, version or release) segment by segment:
+/// numeric segments numerically and newer than alpha segments, alpha
+/// segments lexically, and a longer separator run wins
+int rpmvercmp(const char *a, const char *aEnd, const char *b, const char *bEnd)
+{
+    if (aEnd - a == bEnd - b && std::memcmp(a, b, size_t(aEnd - a)) == 0)
+        return 0;
+
+    const char *one = a;
+    const char *two = b;
+    const char *ptr1 = a;
+    const char *ptr2 = b;
+
+    while (one < aEnd && two < bEnd) {
+        while (one < aEnd && !isAlnum(*one))
+            ++one;
+        while (two < bEnd && !isAlnum(*two))
+            ++two;
+
+        if (one == aEnd || two == bEnd)
+            break;
+
+        // Different separator lengths decide on their own
+        if (one - ptr1 != two - ptr2)
+            return (one - ptr1) < (two - ptr2) ? -1 : 1;
+
+        ptr1 = one;
+        ptr2 = two;
+
+        const bool isNum = isDigit(*ptr1);
+        if (isNum) {
+            while (ptr1 < aEnd && isDigit(*ptr1))
+                ++ptr1;
+            while (ptr2 < bEnd && isDigit(*ptr2))
+                ++ptr2;
+        } else {
+            while (ptr1 < aEnd && isAlpha(*ptr1))
+                ++ptr1;
+            while (ptr2 < bEnd && isAlpha(*ptr2))
+                ++ptr2;
+        }
+
+        // Segments of different type: numeric is newer
+        if (two == ptr2)
+            return isNum ? 1 : -1;
+
+        if (isNum) {
+            while (one < ptr1 - 1 && *one == '0')
+                ++one;
+            while (two < ptr2 - 1 && *two == '0')
+                ++two;
+            if (ptr1 - one != ptr2 - two)
+                return (ptr1 - one) > (ptr2 - two) ? 1 : -1;
+        }
+
+        const size_t len1 = size_t(ptr1 - one);
+        const size_t len2 = size_t(ptr2 - two);
+        const int rc = std::memcmp(one, two, std::min(len1, len2));
+        if (rc != 0)
+            return rc < 0 ? -1 : 1;
+        if (len1 != len2)
+            return len1 < len2 ? -1 : 1;
+
+        one = ptr1;
+        two = ptr2;
+    }
+
+    if (one == aEnd && two == bEnd)
+        return 0;
+
+    // A remaining alpha segment never beats an empty one:
+    // "1.0" > "1.0alpha", but "1.0.1" > "1.0"
+    if ((one == aEnd && !isAlpha(*two)) || (one < aEnd && isAlpha(*one)))
+        return -1;
+    return 1;
+}
+
+struct Evr {
+    const char *epoch;
+    const char *epochEnd;
+    const char *version;
+    const char *versionEnd;
+    const char *release = nullptr;
+    const char *releaseEnd = nullptr;
+};
+
+/// Split "[epoch:]version[-release]"; a missing epoch is "0"
+Evr parseEvr(const QByteArray &evr)
+{
+    static const char zero[] = "0";
+
+    const char *begin = evr.constData();
+    const char *end = begin + evr.size();
+    const char *s = begin;
+    while (s < end && isDigit(*s))
+        ++s;
+
+    Evr parts;
+    if (s < end && *s == ':') {
+        parts.epoch = begin;
+        parts.epochEnd = s;
+        if (parts.epoch == parts.epochEnd) {
+            parts.epoch = zero;
+            parts.epochEnd = zero + 1;
+        }
+        parts.version = s + 1;
+    } else {
+        parts.epoch = zero;
+        parts.epochEnd = zero + 1;
+        parts.version = begin;
+    }
+
+    parts.versionEnd = end;
+    for (const char *p = end; p > parts.version; --p) {
+        if (p[-1] == '-') {
+            parts.versionEnd = p - 1;
+            parts.release = p;
+            parts.releaseEnd = end;
+            break;
+        }
+    }
+    return parts;
+}
+
+} // namespace
+
+int vercmp(const QString &a, const QString &b)
+{
+    if (a == b)
+        return 0;
+
+    const QByteArray full1 = a.toLatin1();
+    const QByteArray full2 = b.toLatin1();
+    const Evr one = parseEvr(full1);
+    const Evr two = parseEvr(full2);
+
+    int ret = rpmvercmp(one.epoch, one.epochEnd, two.epoch, two.epochEnd);
+    if (ret == 0) {
+        ret = rpmvercmp(one.version, one.versionEnd, two.version, two.versionEnd);
+        if (ret == 0 && one.release && two.release)
+            ret = rpmvercmp(one.release, one.releaseEnd, two.release, two.releaseEnd);
+    }
+    return ret;
+}
@@ -0,0 +1,21 @@
+/*
+ * RSCN Drivers - Driver Manager for RSCN OS
+ * Copyright (C) 2026 ReSpring Clips Neko
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef VERCMP_H
+#define VERCMP_H
+
+#include <QString>
+
+/// Compare two pacman package versions ([epoch:]version[-release]) the way
+/// libalpm's alpm_pkg_vercmp does, without forking vercmp(8).
+/// Returns -1 if a is older than b, 0 if equal, 1 if a is newer.
+int vercmp(const QString &a, const QString &b);
+
+#endif // VERCMP_H